@@ -1,4 +1,6 @@
 #include "clonotribe.hpp"
+#include <fstream>
+#include <osdialog.h>
 #include "dsp/drumkits/original/kickdrum.hpp"
 #include "dsp/drumkits/original/snaredrum.hpp"
 #include "dsp/drumkits/original/hihat.hpp"
@@ -39,6 +41,7 @@ void Clonotribe::toggleActiveStep(int step) {
     }
     if (idx >= 0 && idx < sequencer.getStepCount()) {
         sequencer.toggleStepSkipped(idx);
+        markPatternEdited();
     }
 }
 
@@ -63,11 +66,15 @@ void Clonotribe::handleStepButtons(float sampleTime) {
                     sequencer.toggleStepMuted(idx);
                 }
                 selectedStepForEditing = i;
+                markPatternEdited();
             } else if (sequencer.getSelectedDrumPart() != DrumPart::SYNTH) {
                 int drumIdx = static_cast<int>(sequencer.getSelectedDrumPart()) - 1;
-                if (drumIdx >= 0 && drumIdx < 3) {
-                    drumPatterns[drumIdx][i] = !drumPatterns[drumIdx][i];
+                if (isCtrlClick) {
+                    drumPattern.toggleAccent(drumIdx, idx);
+                } else {
+                    drumPattern.toggle(drumIdx, idx);
                 }
+                markPatternEdited();
             }
         }
 
@@ -84,11 +91,14 @@ void Clonotribe::toggleStepInCurrentMode(int step) {
         if (idx >= 0 && idx < sequencer.getStepCount()) {
             bool current = sequencer.isStepMuted(idx);
             sequencer.setStepMuted(idx, !current);
+            markPatternEdited();
         }
     } else {
         int drumIdx = static_cast<int>(sequencer.getSelectedDrumPart()) - 1;
-        if (drumIdx >= 0 && drumIdx < 3 && step >= 0 && step < 8) {
-            drumPatterns[drumIdx][step] = !drumPatterns[drumIdx][step];
+        int idx = sequencer.isInSixteenStepMode() ? sequencer.getStepIndex(step, false) : step;
+        if (idx >= 0 && idx < sequencer.getStepCount()) {
+            drumPattern.toggle(drumIdx, idx);
+            markPatternEdited();
         }
     }
 }
@@ -140,12 +150,13 @@ void Clonotribe::updateStepLights(const Sequencer::SequencerOutput& seqOutput) {
                 lights[base + 2].setBrightness(blue);
             } else {
                 int drumIdx = static_cast<int>(sequencer.getSelectedDrumPart()) - 1;
-                notMuted = (drumIdx >= 0 && drumIdx < 3) ? drumPatterns[drumIdx][i] : false;
-                isPlaying = sequencer.playing && (seqOutput.step == i);
+                notMuted = drumPattern.isSet(drumIdx, mainIdx);
+                isPlaying = sequencer.playing && (seqOutput.step == mainIdx);
 
                 float brightness = notMuted ? (isPlaying ? LIGHT_ACTIVE : LIGHT_ON) : LIGHT_OFF;
+                bool accent = drumPattern.isAccent(drumIdx, mainIdx);
                 lights[base + 0].setBrightness(brightness);
-                lights[base + 1].setBrightness(LIGHT_OFF);
+                lights[base + 1].setBrightness(accent ? brightness : LIGHT_OFF);
                 lights[base + 2].setBrightness(LIGHT_OFF);
             }
         }
@@ -224,10 +235,24 @@ Clonotribe::Clonotribe() : filterProcessor(ms20Filter), ribbonController(this) {
     noiseGenerator.setNoiseType(NoiseType::WHITE);
     filterProcessor.setPointers(&ms20Filter, &ladderFilter, &moogFilter);
     filterProcessor.setType(selectedFilterType);
+    selectVoiceKernel(VCO::Waveform::SQUARE, selectedFilterType, Envelope::Type::ATTACK, LFO::Target::VCF);
     delayProcessor.clear();
+    delayWorker = std::thread([this] {
+        while (!delayWorkerStopping.load(std::memory_order_relaxed)) {
+            delayProcessor.allocate();
+            std::this_thread::sleep_for(DELAY_WORKER_INTERVAL);
+        }
+    });
+}
+
+Clonotribe::~Clonotribe() {
+    delayWorkerStopping.store(true, std::memory_order_relaxed);
+    delayWorker.join();
 }
 
 void Clonotribe::process(const ProcessArgs& args) {
+    DenormalGuard denormalGuard;
+    exchangePattern();
     auto [cutoff, lfoIntensity, lfoRate, noiseLevel, resonance, rhythmVolume, tempo, volume, octave, distortion, envelopeType, lfoMode, lfoTarget, lfoWaveform, ribbonMode, waveform] = readParameters();
 
     updateDSPState(volume, rhythmVolume, lfoIntensity, ribbonMode, octave, cutoff);
@@ -286,7 +311,7 @@ void Clonotribe::process(const ProcessArgs& args) {
     if (!ribbonOverride && seqOutput.accent && paramCache.accentGlideAmount > ZERO) {
         accentBoost = 0.2f * paramCache.accentGlideAmount;
     }
-    float effectiveCutoff = std::clamp(cutoff + accentBoost, ZERO, ONE);
+    float effectiveCutoff = std::clamp(cutoffRamp.process(cutoff) + accentBoost, ZERO, ONE);
 
     static bool prevGate = false;
     float lfoOut = lfo.process(
@@ -298,33 +323,19 @@ void Clonotribe::process(const ProcessArgs& args) {
         lfoIntensity,
         args.sampleTime
     );
-    float lfoToVCO = 0.0f, lfoToVCF = 0.0f;
-    switch (lfoTarget) {
-        case LFO::Target::VCF:
-            lfoToVCF = lfoOut;
-            break;
-        case LFO::Target::VCO_VCF:
-            lfoToVCO = lfoOut * HALF;
-            lfoToVCF = lfoOut;
-            break;
-        case LFO::Target::VCO:
-            lfoToVCO = lfoOut * HALF;
-            break;
-    }
     prevGate = (finalGate > HALF);
 
-    vco.setPitch(finalPitch + lfoToVCO);
-    vco.setWaveform(waveform);
-    float vcoOutput = vco.process(args.sampleTime);
-    
-    vcoOutput = dcBlockerPost.process(vcoOutput);
-    
-    float noise = noiseGenerator.process() * noiseLevel;
-    float mixedSignal = vcoOutput + noise;
+    if (args.sampleRate != voiceBaseRate) {
+        setSampleRate(args.sampleRate);
+    } else if (Oversampler::factorFor(quality.load(std::memory_order_relaxed)) != oversampler.getFactor()) {
+        applyQuality(args.sampleRate);
+    }
+
+    float externalSignal = noiseGenerator.process() * noiseLevel;
 
     float audioIn = inputs[INPUT_AUDIO_CONNECTOR].getVoltage();
     if (inputs[INPUT_AUDIO_CONNECTOR].isConnected()) {
-        mixedSignal += audioIn * 1.5f;
+        externalSignal += audioIn * 1.5f;
     }
 
     bool audioGateActive = false;
@@ -335,20 +346,18 @@ void Clonotribe::process(const ProcessArgs& args) {
         }
     }
 
-    float filteredSignal = filterProcessor.process(
-        mixedSignal,
-        std::clamp(effectiveCutoff + lfoToVCF, ZERO, ONE),
-        resonance
-    );
+    float volumeModulation = std::clamp(ONE + (ribbon.getVolumeAutomation() * HALF), 0.1f, TWO);
+    distortion = distortionRamp.process(distortion);
+    VoiceFrame frame{
+        lfoOut, finalPitch, effectiveCutoff, resonanceRamp.process(resonance), audioGateActive ? 5.0f : finalGate,
+        volumeRamp.process(volume) * volumeModulation, externalSignal, distortion, args.sampleTime
+    };
+    float synthOutput = (this->*voiceKernel)(frame);
 
-    filteredSignal = dcBlockerPostFilter.process(filteredSignal);
-    float effectiveGate = audioGateActive ? 5.0f : finalGate;
-    float envValue = processEnvelope(envelopeType, envelope, args.sampleTime, effectiveGate);
     float delayClock = inputs[INPUT_DELAY_TIME_CONNECTOR].isConnected() ? inputs[INPUT_DELAY_TIME_CONNECTOR].getVoltage() : ZERO;
-    float finalOutput = processOutput(
-        filteredSignal, volume, envValue, ribbon.getVolumeAutomation(),
-        rhythmVolume, args.sampleTime, noiseGenerator, seqOutput.step, distortion,
-        delayClock, paramCache.delayTime, paramCache.delayAmount
+    float_4 finalOutput = processOutput(
+        synthOutput, rhythmVolume, args.sampleTime, noiseGenerator, seqOutput.step, distortion,
+        delayClock, paramCache.delayTime, delayAmountRamp.process(paramCache.delayAmount)
     );
 
     if (outputs[OUTPUT_LFO_RATE_CONNECTOR].isConnected()) {
@@ -361,13 +370,17 @@ void Clonotribe::process(const ProcessArgs& args) {
         outputs[OUTPUT_LFO_RATE_CONNECTOR].setVoltage(ZERO);
     }
     
-    if (distortion <= 0.1f) {
-        finalOutput = FastMath::fastTanh(finalOutput * 0.7f) * 1.3f;
+    // The delay's stereo modes turn the audio output into a 2-channel (left/right) cable.
+    int channels = delayProcessor.getStereo() != Delay::Stereo::MONO ? 2 : 1;
+    outputs[OUTPUT_AUDIO_CONNECTOR].setChannels(channels);
+    for (int c = 0; c < channels; ++c) {
+        float channelOutput = finalOutput[c];
+        if (distortion <= 0.1f) {
+            channelOutput = FastMath::fastTanh(channelOutput * 0.7f) * 1.3f;
+        }
+        float noiseReducedOutput = (c == 0 ? dcBlockerFinal : dcBlockerFinalRight).processFinal(channelOutput);
+        outputs[OUTPUT_AUDIO_CONNECTOR].setVoltage(std::clamp(noiseReducedOutput * 4.0f, -10.0f, 10.0f), c);
     }
-
-    float noiseReducedOutput = dcBlockerFinal.processFinal(finalOutput);
-
-    outputs[OUTPUT_AUDIO_CONNECTOR].setVoltage(std::clamp(noiseReducedOutput * 4.0f, -10.0f, 10.0f));
     outputs[OUTPUT_CV_CONNECTOR].setVoltage(finalPitch);
     outputs[OUTPUT_GATE_CONNECTOR].setVoltage(finalGate);
     bool syncOut = syncPulse.process(args.sampleTime);
@@ -440,6 +453,34 @@ struct NoiseTypeMenuItem : rack::MenuItem {
     }
 };
 
+struct DelayStereoMenuItem : rack::MenuItem {
+    Clonotribe* module;
+    Delay::Stereo stereo;
+    void onAction(const rack::event::Action& e) override {
+        module->delayProcessor.setStereo(stereo);
+    }
+    void step() override {
+        static const char* stereoLabels[] = {"Mono", "Ping-pong (stereo)", "Spread (stereo)"};
+        text = stereoLabels[static_cast<int>(stereo)];
+        rightText = (module->delayProcessor.getStereo() == stereo) ? "✔" : "";
+        MenuItem::step();
+    }
+};
+
+struct QualityMenuItem : rack::MenuItem {
+    Clonotribe* module;
+    Oversampler::Quality quality;
+    void onAction(const rack::event::Action& e) override {
+        module->setQuality(quality);
+    }
+    void step() override {
+        static const char* qualityLabels[] = {"Eco (1x, lowest CPU)", "Normal (2x, ~2.5x voice CPU)", "HQ (4x, ~6x voice CPU)"};
+        text = qualityLabels[static_cast<int>(quality)];
+        rightText = (module->quality.load(std::memory_order_relaxed) == quality) ? "✔" : "";
+        MenuItem::step();
+    }
+};
+
 struct FilterTypeMenuItem : rack::MenuItem {
     Clonotribe* module;
     FilterType filterType;
@@ -464,6 +505,11 @@ void Clonotribe::appendContextMenu(rack::ui::Menu* menu) {
         filterItem->filterType = static_cast<FilterType>(i);
         menu->addChild(filterItem);
     }
+    struct ZdfFilters : rack::MenuItem { Clonotribe* module; void onAction(const rack::event::Action& e) override { module->filterProcessor.setSolver(module->filterProcessor.getSolver() == FilterSolver::ZDF ? FilterSolver::EULER : FilterSolver::ZDF); } void step() override { rightText = module->filterProcessor.getSolver() == FilterSolver::ZDF?"✔":""; MenuItem::step(); } };
+    auto* zdf = new ZdfFilters();
+    zdf->module = this;
+    zdf->text = "Zero-delay Feedback (MS-20, Ladder)";
+    menu->addChild(zdf);
     menu->addChild(new rack::MenuSeparator());
     menu->addChild(rack::createMenuLabel("Drum Kit"));
     for (int i = 0; i < static_cast<int>(DrumKitType::SIZE); ++i) {
@@ -481,6 +527,14 @@ void Clonotribe::appendContextMenu(rack::ui::Menu* menu) {
         menu->addChild(noiseItem);
     }
     menu->addChild(new rack::MenuSeparator());
+    menu->addChild(rack::createMenuLabel("Delay Output"));
+    for (int i = 0; i < 3; ++i) {
+        auto* stereoItem = new DelayStereoMenuItem;
+        stereoItem->module = this;
+        stereoItem->stereo = static_cast<Delay::Stereo>(i);
+        menu->addChild(stereoItem);
+    }
+    menu->addChild(new rack::MenuSeparator());
     menu->addChild(rack::createMenuLabel("Tempo range"));
     static const char* rangeLabels[static_cast<int>(TempoRange::SIZE)] = {
         "10–600 BPM", "20–300 BPM", "60–180 BPM"
@@ -501,30 +555,88 @@ void Clonotribe::appendContextMenu(rack::ui::Menu* menu) {
     menu->addChild(rack::createMenuLabel("Utilities"));
     auto* clearAll = new SimpleActionItem();
     clearAll->text = "Clear All Sequences";
-    clearAll->fn = [this]{ clearAllSequences(); };
+    clearAll->fn = [this]{ requestPatternCommand(CLEAR_ALL_SEQUENCES); };
     menu->addChild(clearAll);
 
     auto* clearSynth = new SimpleActionItem();
     clearSynth->text = "Clear Synth Sequence";
-    clearSynth->fn = [this]{ clearSynthSequence(); };
+    clearSynth->fn = [this]{ requestPatternCommand(CLEAR_SYNTH_SEQUENCE); };
     menu->addChild(clearSynth);
 
     auto* clearDrums = new SimpleActionItem();
     clearDrums->text = "Clear Drum Sequence";
-    clearDrums->fn = [this]{ clearDrumSequence(); };
+    clearDrums->fn = [this]{ requestPatternCommand(CLEAR_DRUM_SEQUENCE); };
     menu->addChild(clearDrums);
 
     auto* enableActive = new SimpleActionItem();
     enableActive->text = "Enable All Active Steps";
-    enableActive->fn = [this]{ enableAllActiveSteps(); };
+    enableActive->fn = [this]{ requestPatternCommand(ENABLE_ALL_ACTIVE_STEPS); };
     menu->addChild(enableActive);
 
-    struct Toggle16 : rack::MenuItem { Clonotribe* module; void onAction(const rack::event::Action& e) override { module->sequencer.setSixteenStepMode(!module->sequencer.isInSixteenStepMode()); if (module->sequencer.currentStep >= module->sequencer.getStepCount()) module->sequencer.currentStep = 0; } void step() override { rightText = module->sequencer.isInSixteenStepMode()?"✔":""; MenuItem::step(); } };
+    auto* exportMidi = new SimpleActionItem();
+    exportMidi->text = "Export Pattern to MIDI...";
+    exportMidi->fn = [this]{
+        osdialog_filters* filters = osdialog_filters_parse("MIDI:mid,midi");
+        char* path = osdialog_file(OSDIALOG_SAVE, nullptr, "pattern.mid", filters);
+        osdialog_filters_free(filters);
+        if (path) {
+            if (!exportPatternToMidi(path)) {
+                osdialog_message(OSDIALOG_WARNING, OSDIALOG_OK, "Could not write the MIDI file.");
+            }
+            std::free(path);
+        }
+    };
+    menu->addChild(exportMidi);
+
+    auto* importMidi = new SimpleActionItem();
+    importMidi->text = "Import Pattern from MIDI...";
+    importMidi->fn = [this]{
+        osdialog_filters* filters = osdialog_filters_parse("MIDI:mid,midi");
+        char* path = osdialog_file(OSDIALOG_OPEN, nullptr, nullptr, filters);
+        osdialog_filters_free(filters);
+        if (path) {
+            if (!importPatternFromMidi(path)) {
+                osdialog_message(OSDIALOG_WARNING, OSDIALOG_OK, "Could not import the MIDI file: it is unreadable, holds no pattern or is too large.");
+            }
+            std::free(path);
+        }
+    };
+    menu->addChild(importMidi);
+
+    struct Toggle16 : rack::MenuItem { Clonotribe* module; void onAction(const rack::event::Action& e) override { module->requestPatternCommand(TOGGLE_SIXTEEN_STEP_MODE); } void step() override { rightText = module->sequencer.isInSixteenStepMode()?"✔":""; MenuItem::step(); } };
     auto* t16 = new Toggle16();
     t16->module = this;
     t16->text = "16-step Mode";
     menu->addChild(t16);
 
+    struct LongDelay : rack::MenuItem { Clonotribe* module; void onAction(const rack::event::Action& e) override { module->setLongDelay(!module->delayProcessor.isLongMode()); } void step() override { rightText = module->delayProcessor.isLongMode()?"✔":""; MenuItem::step(); } };
+    auto* ld = new LongDelay();
+    ld->module = this;
+    ld->text = "Long Delay (10 s)";
+    menu->addChild(ld);
+
+    struct DigitalDelay : rack::MenuItem { Clonotribe* module; void onAction(const rack::event::Action& e) override { module->delayProcessor.setMode(module->delayProcessor.getMode() == Delay::Mode::DIGITAL ? Delay::Mode::TAPE : Delay::Mode::DIGITAL); } void step() override { rightText = module->delayProcessor.getMode() == Delay::Mode::DIGITAL?"✔":""; MenuItem::step(); } };
+    auto* dd = new DigitalDelay();
+    dd->module = this;
+    dd->text = "Digital Delay (no pitch bend)";
+    menu->addChild(dd);
+
+    menu->addChild(new rack::MenuSeparator());
+    menu->addChild(rack::createMenuLabel("Quality (voice oversampling)"));
+    for (int i = 0; i < 3; ++i) {
+        auto* qualityItem = new QualityMenuItem;
+        qualityItem->module = this;
+        qualityItem->quality = static_cast<Oversampler::Quality>(i);
+        menu->addChild(qualityItem);
+    }
+    menu->addChild(new rack::MenuSeparator());
+
+    struct AdaaDistortion : rack::MenuItem { Clonotribe* module; void onAction(const rack::event::Action& e) override { module->distortionProcessor.setAlgorithm(module->distortionProcessor.getAlgorithm() == Distortion::Algorithm::ADAA ? Distortion::Algorithm::CLASSIC : Distortion::Algorithm::ADAA); } void step() override { rightText = module->distortionProcessor.getAlgorithm() == Distortion::Algorithm::ADAA?"✔":""; MenuItem::step(); } };
+    auto* ad = new AdaaDistortion();
+    ad->module = this;
+    ad->text = "Anti-aliased Distortion";
+    menu->addChild(ad);
+
     struct MatchSteps : rack::MenuItem { Clonotribe* module; void onAction(const rack::event::Action& e) override { module->sequencer.setMatchSteps(!module->sequencer.isMatchSteps()); } void step() override { rightText = module->sequencer.isMatchSteps()?"✔":""; MenuItem::step(); } };
     auto* ms = new MatchSteps();
     ms->module = this;
@@ -532,6 +644,126 @@ void Clonotribe::appendContextMenu(rack::ui::Menu* menu) {
     menu->addChild(ms);
 }
 
+// UI thread: reads the pattern as of the last history update, never the audio thread's copy.
+MidiPattern Clonotribe::getPattern() const {
+    MidiPattern pattern;
+    if (auto snapshot = patternHistory.current()) {
+        snapshot->copyTo(pattern.steps);
+        pattern.stepCount = snapshot->sixteenStepMode ? Sequencer::MAX_STEPS : Sequencer::DEFAULT_STEPS;
+        pattern.drums = snapshot->drums;
+    }
+    return pattern;
+}
+
+// UI thread: hands the pattern to the audio thread like an undo step. It comes back as an
+// edit, so the import gets its own undo step.
+void Clonotribe::setPattern(const MidiPattern& pattern) {
+    PatternState state;
+    state.steps = pattern.steps;
+    state.drums = pattern.drums;
+    state.sixteenStepMode = pattern.stepCount > Sequencer::DEFAULT_STEPS;
+    patternHandoff.publish(patternHistory.snapshot(state), true);
+}
+
+bool Clonotribe::updatePatternHistory() {
+    patternHandoff.collect();
+    const PatternEdit* edit = patternMailbox.take();
+    if (!edit) {
+        return false;
+    }
+    if (edit->generation != historyGeneration) {
+        historyGeneration = edit->generation;
+        patternHistory.reset(edit->state);
+        return false;
+    }
+    // Edits made before the audio thread adopted the latest undo/redo are overwritten by it.
+    if (edit->basis != patternHandoff.latest()) {
+        return false;
+    }
+    return patternHistory.commit(edit->state);
+}
+
+void Clonotribe::undoPatternEdit() {
+    if (auto snapshot = patternHistory.undo()) {
+        patternHandoff.publish(std::move(snapshot), false);
+    }
+}
+
+void Clonotribe::redoPatternEdit() {
+    if (auto snapshot = patternHistory.redo()) {
+        patternHandoff.publish(std::move(snapshot), false);
+    }
+}
+
+void Clonotribe::exchangePattern() {
+    if (const auto* publication = patternHandoff.take()) {
+        const PatternSnapshot& snapshot = *publication->snapshot;
+        snapshot.copyTo(sequencer.steps);
+        drumPattern = snapshot.drums;
+        sequencer.setSixteenStepMode(snapshot.sixteenStepMode);
+        if (sequencer.currentStep >= sequencer.getStepCount()) {
+            sequencer.currentStep = 0;
+        }
+        appliedPatternSequence = publication->sequence;
+        patternDirty = publication->recordsEdit;
+        patternHandoff.acknowledge(publication);
+    }
+
+    uint32_t commands = patternCommands.exchange(0, std::memory_order_acquire);
+    if (commands & CLEAR_ALL_SEQUENCES) clearAllSequences();
+    if (commands & CLEAR_SYNTH_SEQUENCE) clearSynthSequence();
+    if (commands & CLEAR_DRUM_SEQUENCE) clearDrumSequence();
+    if (commands & ENABLE_ALL_ACTIVE_STEPS) enableAllActiveSteps();
+    if (commands & TOGGLE_SIXTEEN_STEP_MODE) {
+        sequencer.setSixteenStepMode(!sequencer.isInSixteenStepMode());
+        if (sequencer.currentStep >= sequencer.getStepCount()) {
+            sequencer.currentStep = 0;
+        }
+        markPatternEdited();
+    }
+
+    if (!patternDirty) {
+        return;
+    }
+    PatternEdit& edit = patternMailbox.edit();
+    edit.state.steps = sequencer.steps;
+    edit.state.drums = drumPattern;
+    edit.state.sixteenStepMode = sequencer.isInSixteenStepMode();
+    edit.basis = appliedPatternSequence;
+    edit.generation = patternGeneration;
+    patternMailbox.publish();
+    patternDirty = false;
+}
+
+bool Clonotribe::exportPatternToMidi(const std::string& path) {
+    std::ofstream file(path, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    float minTempo, maxTempo;
+    getTempoRange(minTempo, maxTempo);
+    float bpm = rack::math::rescale(params[PARAM_SEQUENCER_TEMPO_KNOB].getValue(), ZERO, ONE, minTempo, maxTempo);
+    if (!writeMidiPatterns(file, {getPattern()}, bpm)) {
+        return false;
+    }
+    // Buffered data is only written, and a full disk only noticed, on close.
+    file.close();
+    return !file.fail();
+}
+
+bool Clonotribe::importPatternFromMidi(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    std::vector<MidiPattern> patterns;
+    if (!readMidiPatterns(file, patterns) || patterns.empty()) {
+        return false;
+    }
+    setPattern(patterns.front());
+    return true;
+}
+
 json_t* Clonotribe::dataToJson() {
     json_t* rootJ = json_object();
     
@@ -557,15 +789,14 @@ json_t* Clonotribe::dataToJson() {
     }
     json_object_set_new(sequencerJ, "steps", stepsJ);
     
-    json_t* drumPatternsJ = json_array();
-    for (int d = 0; d < 3; d++) {
-        json_t* drumJ = json_array();
-        for (int s = 0; s < 8; s++) {
-            json_array_append_new(drumJ, json_boolean(drumPatterns[d][s]));
-        }
-        json_array_append_new(drumPatternsJ, drumJ);
+    json_t* drumMasksJ = json_array();
+    json_t* drumAccentsJ = json_array();
+    for (int d = 0; d < DrumPattern::LANES; d++) {
+        json_array_append_new(drumMasksJ, json_integer(static_cast<json_int_t>(drumPattern.hits[d])));
+        json_array_append_new(drumAccentsJ, json_integer(static_cast<json_int_t>(drumPattern.accents[d])));
     }
-    json_object_set_new(sequencerJ, "drumPatterns", drumPatternsJ);
+    json_object_set_new(sequencerJ, "drumMasks", drumMasksJ);
+    json_object_set_new(sequencerJ, "drumAccents", drumAccentsJ);
     
     json_object_set_new(rootJ, "sequencer", sequencerJ);
     
@@ -578,6 +809,12 @@ json_t* Clonotribe::dataToJson() {
     json_object_set_new(rootJ, "selectedTempoRange", json_integer(static_cast<int>(selectedTempoRange)));
     json_object_set_new(rootJ, "selectedNoiseType", json_integer(static_cast<int>(selectedNoiseType)));
     json_object_set_new(rootJ, "matchSteps", json_boolean(sequencer.isMatchSteps()));
+    json_object_set_new(rootJ, "longDelay", json_boolean(delayProcessor.isLongMode()));
+    json_object_set_new(rootJ, "delayMode", json_integer(static_cast<int>(delayProcessor.getMode())));
+    json_object_set_new(rootJ, "delayStereo", json_integer(static_cast<int>(delayProcessor.getStereo())));
+    json_object_set_new(rootJ, "distortionAlgorithm", json_integer(static_cast<int>(distortionProcessor.getAlgorithm())));
+    json_object_set_new(rootJ, "quality", json_integer(static_cast<int>(quality.load(std::memory_order_relaxed))));
+    json_object_set_new(rootJ, "filterSolver", json_integer(static_cast<int>(filterProcessor.getSolver())));
     
     return rootJ;
 }
@@ -631,23 +868,42 @@ void Clonotribe::dataFromJson(json_t* rootJ) {
                         if (glideJ) sequencer.steps[stepIndex].glide = json_boolean_value(glideJ);
                 }
             }
+            sequencer.updateStepTable();
         }
         
+        json_t* drumMasksJ = json_object_get(sequencerJ, "drumMasks");
+        json_t* drumAccentsJ = json_object_get(sequencerJ, "drumAccents");
         json_t* drumPatternsJ = json_object_get(sequencerJ, "drumPatterns");
-        if (drumPatternsJ) {
+        if (drumMasksJ) {
+            drumPattern.clear();
+            size_t drumIndex;
+            json_t* maskJ;
+            json_array_foreach(drumMasksJ, drumIndex, maskJ) {
+                if (drumIndex < DrumPattern::LANES) {
+                    drumPattern.hits[drumIndex] = static_cast<uint64_t>(json_integer_value(maskJ));
+                }
+            }
+            if (drumAccentsJ) {
+                json_array_foreach(drumAccentsJ, drumIndex, maskJ) {
+                    if (drumIndex < DrumPattern::LANES) {
+                        drumPattern.accents[drumIndex] = static_cast<uint64_t>(json_integer_value(maskJ));
+                    }
+                }
+            }
+        } else if (drumPatternsJ) {
+            std::array<std::array<bool, DrumPattern::LEGACY_STEPS>, DrumPattern::LANES> legacy{};
             size_t drumIndex;
             json_t* drumJ;
             json_array_foreach(drumPatternsJ, drumIndex, drumJ) {
-                if (drumIndex < 3) {
-                    size_t stepIndex;
-                    json_t* stepJ;
-                    json_array_foreach(drumJ, stepIndex, stepJ) {
-                        if (stepIndex < 8) {
-                            drumPatterns[drumIndex][stepIndex] = json_boolean_value(stepJ);
-                        }
+                size_t stepIndex;
+                json_t* stepJ;
+                json_array_foreach(drumJ, stepIndex, stepJ) {
+                    if (drumIndex < legacy.size() && stepIndex < legacy[drumIndex].size()) {
+                        legacy[drumIndex][stepIndex] = json_boolean_value(stepJ);
                     }
                 }
             }
+            drumPattern = DrumPattern::fromLegacy(legacy, sequencer.isInSixteenStepMode());
         }
     }
     
@@ -694,9 +950,45 @@ void Clonotribe::dataFromJson(json_t* rootJ) {
     if (matchStepsJ) {
         sequencer.setMatchSteps(json_boolean_value(matchStepsJ));
     }
+
+    json_t* longDelayJ = json_object_get(rootJ, "longDelay");
+    if (longDelayJ) {
+        setLongDelay(json_boolean_value(longDelayJ));
+    }
+
+    json_t* delayModeJ = json_object_get(rootJ, "delayMode");
+    if (delayModeJ) {
+        delayProcessor.setMode(static_cast<Delay::Mode>(json_integer_value(delayModeJ)));
+    }
+
+    json_t* delayStereoJ = json_object_get(rootJ, "delayStereo");
+    if (delayStereoJ) {
+        delayProcessor.setStereo(static_cast<Delay::Stereo>(json_integer_value(delayStereoJ)));
+    }
+
+    json_t* distortionAlgorithmJ = json_object_get(rootJ, "distortionAlgorithm");
+    if (distortionAlgorithmJ) {
+        distortionProcessor.setAlgorithm(static_cast<Distortion::Algorithm>(json_integer_value(distortionAlgorithmJ)));
+    }
+
+    json_t* filterSolverJ = json_object_get(rootJ, "filterSolver");
+    if (filterSolverJ) {
+        filterProcessor.setSolver(json_integer_value(filterSolverJ) == 1 ? FilterSolver::ZDF : FilterSolver::EULER);
+    }
+
+    json_t* qualityJ = json_object_get(rootJ, "quality");
+    setQuality(qualityJ
+        ? static_cast<Oversampler::Quality>(std::clamp(static_cast<int>(json_integer_value(qualityJ)), 0, 2))
+        : Oversampler::Quality::ECO);
+
+    // The loaded pattern replaces any undo/redo still on its way and starts a fresh history.
+    appliedPatternSequence = patternHandoff.discard();
+    ++patternGeneration;
+    markPatternEdited();
 }
 
 void Clonotribe::processBypass(const ProcessArgs& args) {
+    outputs[OUTPUT_AUDIO_CONNECTOR].setChannels(1);
     if (inputs[INPUT_AUDIO_CONNECTOR].isConnected()) {
         outputs[OUTPUT_AUDIO_CONNECTOR].setVoltage(inputs[INPUT_AUDIO_CONNECTOR].getVoltage());
     } else {
@@ -747,8 +1039,9 @@ void Clonotribe::onRandomize(const RandomizeEvent& e) {
         sequencer.steps[i].skipped = false;
     }
     
-    for (int drum = 0; drum < 3; drum++) {
-        for (int step = 0; step < 8; step++) {
+    drumPattern.clear();
+    for (int drum = 0; drum < DrumPattern::LANES; drum++) {
+        for (int step = 0; step < Sequencer::MAX_STEPS; step++) {
             float probability;
             switch (drum) {
                 case 0:
@@ -765,7 +1058,7 @@ void Clonotribe::onRandomize(const RandomizeEvent& e) {
                     break;
             }
             
-            drumPatterns[drum][step] = (rack::random::uniform() < probability);
+            drumPattern.set(drum, step, rack::random::uniform() < probability);
         }
     }
     
@@ -774,6 +1067,8 @@ void Clonotribe::onRandomize(const RandomizeEvent& e) {
     } else {
         sequencer.setSixteenStepMode(false);
     }
+    sequencer.updateStepTable();
+    markPatternEdited();
     
     sequencer.fluxMode = (rack::random::uniform() < 0.2f);
     
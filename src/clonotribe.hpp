@@ -9,16 +9,45 @@
 #include "dsp/vcf/filter_type.hpp"
 #include "dsp/delay.hpp"
 #include "dsp/dc_blocker.hpp"
+#include "dsp/denormal.hpp"
+#include "dsp/oversampler.hpp"
+#include "dsp/parameter_ramp.hpp"
+#include "dsp/sequencer/midi_file.hpp"
+#include "dsp/sequencer/pattern_history.hpp"
+#include <atomic>
+#include <thread>
 #include "ui/ui.hpp"
 #include "constants.hpp"
 
 using namespace clonotribe;
 
 struct Clonotribe : rack::Module {
-    static float processEnvelope(Envelope::Type envelopeType, Envelope& envelope, float sampleTime, float finalSequencerGate);
-    float processOutput(
-        float filteredSignal, float volume, float envValue, float ribbonVolumeAutomation,
-        float rhythmVolume, float sampleTime, NoiseGenerator& noiseGenerator, int currentStep, float distortion,
+    template<Envelope::Type E>
+    static void processEnvelope(Envelope& envelope, float finalSequencerGate, float* gains, int frames);
+
+    // Host-rate inputs to the voice kernel.
+    struct VoiceFrame {
+        float lfo;
+        float pitch;
+        float cutoff;
+        float resonance;
+        float gate;
+        float gain;
+        float external;
+        float distortion;
+        float sampleTime;
+    };
+
+    // One kernel per (VCO waveform, filter type, envelope type, LFO target), picked from a
+    // constexpr table at control rate so the per-sample path has no mode switches.
+    using VoiceKernel = float (Clonotribe::*)(const VoiceFrame&);
+    template<VCO::Waveform W, FilterType F, Envelope::Type E, LFO::Target T>
+    float processVoice(const VoiceFrame& frame);
+    void selectVoiceKernel(VCO::Waveform waveform, FilterType filterType, Envelope::Type envelopeType, LFO::Target lfoTarget);
+    VoiceKernel voiceKernel = nullptr;
+    float processDistortion(float synthOutput, float distortion);
+    float_4 processOutput(
+        float synthOutput, float rhythmVolume, float sampleTime, NoiseGenerator& noiseGenerator, int currentStep, float distortion,
         float delayClock, float delayTime, float delayAmount
     );
     
@@ -45,10 +74,22 @@ struct Clonotribe : rack::Module {
         selectedNoiseType = type;
         noiseGenerator.setNoiseType(type);
     }
+
+    // Runs Delay::allocate() off the audio thread: the delay line is allocated once the delay is
+    // first used, and the lines it replaces are freed here.
+    static constexpr auto DELAY_WORKER_INTERVAL = std::chrono::milliseconds(10);
+    std::thread delayWorker;
+    std::atomic<bool> delayWorkerStopping{false};
+
+    void setLongDelay(bool enabled) {
+        delayProcessor.setLongMode(enabled);
+        float maxTime = enabled ? Delay::LONG_DELAY_TIME : Delay::MAX_DELAY_TIME;
+        paramQuantities[PARAM_DELAY_TIME_KNOB]->displayMultiplier = maxTime - MIN;
+    }
     
-    void triggerKick() { drumProcessor.triggerKick(); }
-    void triggerSnare() { drumProcessor.triggerSnare(); }
-    void triggerHihat() { drumProcessor.triggerHihat(); }
+    void triggerKick(float accent = ZERO) { drumProcessor.triggerKick(accent); }
+    void triggerSnare(float accent = ZERO) { drumProcessor.triggerSnare(accent); }
+    void triggerHihat(float accent = ZERO) { drumProcessor.triggerHihat(accent); }
     Ribbon ribbon;
     FilterProcessor filterProcessor;
     LadderFilter ladderFilter;
@@ -88,6 +129,45 @@ struct Clonotribe : rack::Module {
     DcBlocker dcBlockerPostFilter;
     DcBlocker dcBlockerPostDist;
     DcBlocker dcBlockerFinal;
+    DcBlocker dcBlockerFinalRight;
+
+    // The quality is chosen on the UI thread; process() applies it to the voice chain. New
+    // instances start at NORMAL, patches saved before the setting existed load as ECO, which is
+    // how they were rendered.
+    Oversampler oversampler;
+    std::atomic<Oversampler::Quality> quality{Oversampler::Quality::NORMAL};
+    float voiceBaseRate = ZERO;
+
+    // Not for the audio thread: the filter table for the new voice rate is built here.
+    void setQuality(Oversampler::Quality newQuality) {
+        filterProcessor.prepareSampleRate(APP->engine->getSampleRate() * static_cast<float>(Oversampler::factorFor(newQuality)));
+        quality.store(newQuality, std::memory_order_relaxed);
+    }
+
+    void applyQuality(float sampleRate) {
+        int factor = Oversampler::factorFor(quality.load(std::memory_order_relaxed));
+        float voiceRate = sampleRate * static_cast<float>(factor);
+        voiceBaseRate = sampleRate;
+        oversampler.setFactor(factor);
+        filterProcessor.setSampleRate(voiceRate);
+        envelope.setSampleRate(voiceRate);
+        dcBlockerPost.setSampleRate(voiceRate);
+        dcBlockerPostFilter.setSampleRate(voiceRate);
+        distortionProcessor.setOversampling(factor);
+        for (ParameterRamp* ramp : {&cutoffRamp, &resonanceRamp, &volumeRamp, &distortionRamp, &delayAmountRamp}) {
+            ramp->setSampleRate(sampleRate);
+        }
+    }
+
+    // Knob and CV values are ramped at the host rate. The LFO, accent and ribbon modulation is
+    // applied on top of the ramped values, so it reaches the voice unsmoothed.
+    static constexpr float FILTER_RAMP_MS = 2.0f;
+    static constexpr float LEVEL_RAMP_MS = 5.0f;
+    ParameterRamp cutoffRamp{FILTER_RAMP_MS};
+    ParameterRamp resonanceRamp{FILTER_RAMP_MS};
+    ParameterRamp volumeRamp{LEVEL_RAMP_MS};
+    ParameterRamp distortionRamp{LEVEL_RAMP_MS};
+    ParameterRamp delayAmountRamp{LEVEL_RAMP_MS};
 
     bool stepCtrlLatch[8] = {false, false, false, false, false, false, false, false};
     float stepPrevVal[8] = {ZERO, ZERO, ZERO, ZERO, ZERO, ZERO, ZERO, ZERO};
@@ -95,7 +175,29 @@ struct Clonotribe : rack::Module {
     int selectedStepForEditing = 0;
     int syncDivideCounter = 0;
 
-    bool drumPatterns[3][8] = {{false}};
+    DrumPattern drumPattern;
+
+    // The audio thread owns sequencer.steps and drumPattern. After an edit it posts a copy to
+    // patternMailbox, which the UI thread turns into history snapshots. Undo, redo and imports
+    // go the other way through patternHandoff and are adopted at the top of process().
+    // Menu actions that edit the pattern only set a bit in patternCommands.
+    enum PatternCommand : uint32_t {
+        CLEAR_ALL_SEQUENCES = 1u << 0,
+        CLEAR_SYNTH_SEQUENCE = 1u << 1,
+        CLEAR_DRUM_SEQUENCE = 1u << 2,
+        ENABLE_ALL_ACTIVE_STEPS = 1u << 3,
+        TOGGLE_SIXTEEN_STEP_MODE = 1u << 4
+    };
+    PatternHistory patternHistory;
+    PatternMailbox patternMailbox;
+    PatternHandoff patternHandoff;
+    std::atomic<uint32_t> patternCommands{0};
+    bool patternDirty = true;
+    uint32_t appliedPatternSequence = 0;
+    uint32_t patternGeneration = 1;
+    uint32_t historyGeneration = 0;
+
+    void requestPatternCommand(PatternCommand command) { patternCommands.fetch_or(command, std::memory_order_release); }
 
     bool activeStepActive = false;    
     bool activeStepWasPressed = false;
@@ -107,31 +209,54 @@ struct Clonotribe : rack::Module {
     bool syncHalfTempo = false;
 
     Clonotribe();
+    ~Clonotribe() override;
     void process(const ProcessArgs& args) override;
     void processBypass(const ProcessArgs& args) override;
     void onRandomize(const RandomizeEvent& e) override;
     
-    void onSampleRateChange() override {
-        drumProcessor.setSampleRate(APP->engine->getSampleRate());
-        delayProcessor.setSampleRate(APP->engine->getSampleRate());
-        
-        float sampleRate = APP->engine->getSampleRate();
-        dcBlockerPost.setSampleRate(sampleRate);
+    // Recomputes every rate-dependent coefficient: once per change, never on the per-sample
+    // path. process() also calls it when the engine rate differs from the last one seen.
+    void setSampleRate(float sampleRate) {
+        drumProcessor.setSampleRate(sampleRate);
+        delayProcessor.setSampleRate(sampleRate);
+
         dcBlockerPost.setCutoff(30.0f);
-        
-        dcBlockerPostFilter.setSampleRate(sampleRate);
         dcBlockerPostFilter.setCutoff(20.0f);
-        
+
         dcBlockerPostDist.setSampleRate(sampleRate);
         dcBlockerPostDist.setCutoff(15.0f);
         
         dcBlockerFinal.setSampleRate(sampleRate);
         dcBlockerFinal.setCutoff(10.0f);
+        dcBlockerFinalRight.setSampleRate(sampleRate);
+        dcBlockerFinalRight.setCutoff(10.0f);
+
+        applyQuality(sampleRate);
+    }
+
+    // The engine does not process while the rate changes, so the filter table is built,
+    // adopted and the previous one released here rather than in process().
+    void onSampleRateChange() override {
+        float sampleRate = APP->engine->getSampleRate();
+        filterProcessor.prepareSampleRate(sampleRate * static_cast<float>(Oversampler::factorFor(quality.load(std::memory_order_relaxed))));
+        setSampleRate(sampleRate);
+        filterProcessor.collectTables();
+    }
+
+    // The module id is stored with the patch, so a reloaded patch gets the same S&H sequence.
+    void onAdd() override {
+        lfo.setSeed(static_cast<uint32_t>(id));
     }
 
     void onReset() override {
         Module::onReset();
         delayProcessor.clear();
+        setLongDelay(false);
+        delayProcessor.setMode(Delay::Mode::TAPE);
+        delayProcessor.setStereo(Delay::Stereo::MONO);
+        distortionProcessor.setAlgorithm(Distortion::Algorithm::CLASSIC);
+        filterProcessor.setSolver(FilterSolver::EULER);
+        setQuality(Oversampler::Quality::NORMAL);
         clearAllSequences();
     }
 
@@ -147,6 +272,15 @@ struct Clonotribe : rack::Module {
     json_t* dataToJson() override;
     void dataFromJson(json_t* rootJ) override;
 
+    bool updatePatternHistory();
+    void undoPatternEdit();
+    void redoPatternEdit();
+
+    MidiPattern getPattern() const;
+    void setPattern(const MidiPattern& pattern);
+    bool exportPatternToMidi(const std::string& path);
+    bool importPatternFromMidi(const std::string& path);
+
 public:
     TempoRange selectedTempoRange = TempoRange::T10_600;
 
@@ -160,6 +294,8 @@ public:
     }
 
 private:
+    void markPatternEdited() { patternDirty = true; }
+    void exchangePattern();
     void clearAllSequences();
     void clearDrumSequence();
     void clearSynthSequence();
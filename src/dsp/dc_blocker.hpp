@@ -1,8 +1,13 @@
 #pragma once
+#include <array>
 #include "fastmath.hpp"
+#include "simd.hpp"
 
 namespace clonotribe {
 
+// Cascade of up to four one-pole DC blockers. Every stage is linear, so they run fused:
+// a stage's previous input is the previous stage's previous output, leaving one input
+// state plus one state per stage and a single clamp on the way in.
 class DcBlocker final {
 public:
     DcBlocker() noexcept {
@@ -21,80 +26,101 @@ public:
     }
     
     [[nodiscard]] float process(float x) noexcept {
-        return processStage1(x);
+        return processStages<1>(x);
     }
     
     [[nodiscard]] float processAggressive(float x) noexcept {
-        float stage1 = processStage1(x);
-        return processStage2(stage1);
+        return processStages<2>(x);
     }
     
+    // Both high-passes plus the slow DC tracker and the sub-cutoff high-pass.
     [[nodiscard]] float processFinal(float x) noexcept {
-        float stage1 = processStage1(x);
-        float stage2 = processStage2(stage1);
-        return processStage3(stage2);
+        return processStages<STAGES>(x) * DC_TRACKER_GAIN;
     }
     
     void reset() noexcept { 
-        x1 = x2 = x3 = ZERO;
-        y1 = y2 = y3 = ZERO;
-        dcEstimate = ZERO;
+        input = ZERO;
+        state.fill(ZERO);
     }
     
 private:
+    static constexpr int STAGES = 4;
+    // "x - one-pole lowpass(x)" is a DC blocker with its pole at 1 - alpha and gain 1 - alpha.
+    static constexpr float DC_TRACKER_ALPHA = 0.0001f;
+    static constexpr float DC_TRACKER_GAIN = ONE - DC_TRACKER_ALPHA;
+
     float sampleRate = 44100.0f;
     float cutoff = 20.0f;
-    float R1 = 0.995f, R2 = 0.998f, R3 = 0.9995f;
-    float x1 = ZERO, x2 = ZERO, x3 = ZERO;
-    float y1 = ZERO, y2 = ZERO, y3 = ZERO;
-    float dcEstimate = ZERO;
+    std::array<float, STAGES> poles{0.995f, 0.998f, DC_TRACKER_GAIN, 0.9995f};
+    float input = ZERO;
+    std::array<float, STAGES> state{};
 
     void updateCoefficients() noexcept {
         const float invSampleRate = ONE / sampleRate;
         
         const float w1 = FastMath::TWO_PI * cutoff * invSampleRate;
-        R1 = (ONE - w1) / (ONE + w1);
-        R1 = std::clamp(R1, 0.9f, 0.998f);
+        poles[0] = std::clamp((ONE - w1) / (ONE + w1), 0.9f, 0.998f);
         
         const float w2 = FastMath::TWO_PI * (cutoff * HALF) * invSampleRate;
-        R2 = (ONE - w2) / (ONE + w2);
-        R2 = std::clamp(R2, 0.95f, 0.999f);
+        poles[1] = std::clamp((ONE - w2) / (ONE + w2), 0.95f, 0.999f);
         
         const float w3 = FastMath::TWO_PI * (cutoff * 0.25f) * invSampleRate;
-        R3 = (ONE - w3) / (ONE + w3);
-        R3 = std::clamp(R3, 0.98f, 0.9999f);
+        poles[3] = std::clamp((ONE - w3) / (ONE + w3), 0.98f, 0.9999f);
     }
     
-    [[nodiscard]] float processStage1(float x) noexcept {
-        if (std::abs(x) < 1e-30f) x = ZERO;
+    template<int N>
+    [[nodiscard]] float processStages(float x) noexcept {
         x = std::clamp(x, -100.0f, 100.0f);
-        
-        const float y = x - x1 + R1 * y1;
+        float difference = x - input;
+        input = x;
+        for (size_t i = 0; i < N; ++i) {
+            float y = difference + poles[i] * state[i];
+            difference = y - state[i];
+            state[i] = y;
+        }
+        return state[N - 1];
+    }
+};
+
+// First-stage DC blocker for up to four channels at once (the stereo delay feedback path).
+class DcBlocker4 final {
+public:
+    DcBlocker4() noexcept {
+        updateCoefficients();
+    }
+
+    void setSampleRate(float sampleRate) noexcept {
+        this->sampleRate = (sampleRate > 100.0f) ? sampleRate : 44100.0f;
+        updateCoefficients();
+    }
+
+    void setCutoff(float fcHz) noexcept {
+        cutoff = std::clamp(fcHz, ONE, 100.0f);
+        updateCoefficients();
+    }
+
+    [[nodiscard]] float_4 process(float_4 x) noexcept {
+        x = rack::simd::clamp(x, -100.0f, 100.0f);
+        const float_4 y = x - x1 + R1 * y1;
         x1 = x;
-        y1 = (std::abs(y) < 1e-30f) ? ZERO : y;
-        return y1;
+        y1 = y;
+        return y;
     }
-    
-    [[nodiscard]] float processStage2(float x) noexcept {
-        if (std::abs(x) < 1e-30f) x = ZERO;
-        
-        const float y = x - x2 + R2 * y2;
-        x2 = x;
-        y2 = (std::abs(y) < 1e-30f) ? ZERO : y;
-        return y2;
+
+    void reset() noexcept {
+        x1 = y1 = float_4::zero();
     }
-    
-    [[nodiscard]] float processStage3(float x) noexcept {
-        if (std::abs(x) < 1e-30f) x = ZERO;
-        
-        const float dcAlpha = 0.0001f;
-        dcEstimate = dcEstimate * (ONE - dcAlpha) + x * dcAlpha;
-        x -= dcEstimate;
-        
-        const float y = x - x3 + R3 * y3;
-        x3 = x;
-        y3 = (std::abs(y) < 1e-30f) ? ZERO : y;
-        return y3;
+
+private:
+    float sampleRate = 44100.0f;
+    float cutoff = 20.0f;
+    float R1 = 0.995f;
+    float_4 x1 = float_4::zero();
+    float_4 y1 = float_4::zero();
+
+    void updateCoefficients() noexcept {
+        const float w1 = FastMath::TWO_PI * cutoff / sampleRate;
+        R1 = std::clamp((ONE - w1) / (ONE + w1), 0.9f, 0.998f);
     }
 };
 }
\ No newline at end of file
@@ -1,50 +1,367 @@
 #pragma once
-#include <vector>
+#include <algorithm>
+#include <atomic>
 #include <cmath>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
 #include "dc_blocker.hpp"
+#include "simd.hpp"
 
 namespace clonotribe {
 
 class Delay {
 public:
+    static constexpr float MAX_DELAY_TIME = TWO;
+    static constexpr float LONG_DELAY_TIME = 10.0f;
+    static constexpr float MAX_SAMPLE_RATE = 192000.0f;
+    static constexpr float CROSSFADE_TIME = 0.03f;
+    static constexpr float SPREAD_TIME = 0.012f;
+
+    // TAPE glides the read position towards a new time (pitch bend), DIGITAL crossfades
+    // between two fixed read heads.
+    enum class Mode { TAPE, DIGITAL };
+
+    // PING_PONG feeds the input to the left side and crosses the feedback between sides,
+    // SPREAD delays the right side a little longer than the left.
+    enum class Stereo { MONO, PING_PONG, SPREAD };
+
+    // Power-of-two line of interleaved frames. The 2 s line keeps float samples. The 10 s line
+    // stores 16 bits per sample, bounded to ±12 V (input ±10 V plus feedback ±2 V), which leaves
+    // a resolution of about 0.4 mV and fits ten stereo seconds at 192 kHz in 8 MiB.
+    template<typename Sample>
+    struct Line final {
+        static constexpr float RANGE = 12.0f;
+        static constexpr float SCALE = 32767.0f / RANGE;
+
+        Line(uint32_t frames, uint32_t channels) : samples(static_cast<size_t>(frames) * channels, Sample{}), mask(frames - 1), channels(channels) {}
+
+        std::vector<Sample> samples;
+        uint32_t mask;
+        uint32_t channels;
+
+        [[nodiscard]] uint32_t frames() const noexcept { return mask + 1; }
+
+        [[nodiscard]] float at(uint32_t frame, uint32_t channel) const noexcept {
+            return decode(samples[(frame & mask) * channels + channel]);
+        }
+
+        void write(uint32_t frame, uint32_t channel, float x) noexcept {
+            samples[(frame & mask) * channels + channel] = encode(x);
+        }
+
+        [[nodiscard]] static Sample encode(float x) noexcept {
+            if constexpr (std::is_same_v<Sample, float>) {
+                return x;
+            } else {
+                float scaled = std::clamp(x, -RANGE, RANGE) * SCALE;
+                return static_cast<Sample>(scaled + (scaled >= ZERO ? HALF : -HALF));
+            }
+        }
+        [[nodiscard]] static float decode(Sample s) noexcept {
+            if constexpr (std::is_same_v<Sample, float>) {
+                return s;
+            } else {
+                return static_cast<float>(s) * (ONE / SCALE);
+            }
+        }
+    };
+    using ShortLine = Line<float>;
+    using LongLine = Line<int16_t>;
+
+    // Hands one line from the allocating thread to the audio thread. A replaced or dropped line
+    // is kept until the audio thread has let go of it, and is freed on the allocating thread.
+    template<typename L>
+    class LineSlot final {
+    public:
+        // Allocating thread: makes sure the line holds at least this much. Never shrinks.
+        void grow(uint32_t frames, uint32_t channels) {
+            if (owned) {
+                if (owned->frames() >= frames && owned->channels >= channels) return;
+                channels = std::max(channels, owned->channels);
+                retired.push_back(std::move(owned));
+            }
+            owned = std::make_unique<L>(frames, channels);
+            published.store(owned.get(), std::memory_order_release);
+        }
+
+        // Allocating thread.
+        void drop() {
+            if (!owned) return;
+            published.store(nullptr, std::memory_order_release);
+            retired.push_back(std::move(owned));
+        }
+
+        // Allocating thread: once the audio thread uses the current line, no older one is in use.
+        void collect() noexcept {
+            if (inUse.load(std::memory_order_acquire) == published.load(std::memory_order_relaxed)) {
+                retired.clear();
+            }
+        }
+
+        // Audio thread: picks up the current line and acknowledges it.
+        [[nodiscard]] L* acquire() noexcept {
+            L* line = published.load(std::memory_order_acquire);
+            inUse.store(line, std::memory_order_release);
+            return line;
+        }
+
+        // Audio thread, once it stops reading this slot.
+        void release() noexcept { inUse.store(nullptr, std::memory_order_release); }
+
+        // Only while the audio thread is not running.
+        [[nodiscard]] L* current() const noexcept { return published.load(std::memory_order_acquire); }
+
+        [[nodiscard]] bool allocated() const noexcept { return owned != nullptr; }
+        [[nodiscard]] size_t retainedLines() const noexcept { return retired.size(); }
+
+    private:
+        std::atomic<L*> published{nullptr};
+        std::atomic<L*> inUse{nullptr};
+        std::unique_ptr<L> owned;
+        std::vector<std::unique_ptr<L>> retired;
+    };
+
+    // Sized for the given time at the highest supported rate, so sample rate changes never reallocate.
+    [[nodiscard]] static constexpr uint32_t lineSize(float seconds) noexcept {
+        uint32_t size = 1;
+        while (static_cast<float>(size) < seconds * MAX_SAMPLE_RATE + TWO) size <<= 1;
+        return size;
+    }
+
     Delay() {
         setSampleRate(44100.0f);
-        setMaxDelayTime(TWO);
-        feedbackDcBlocker.setSampleRate(44100.0f);
         feedbackDcBlocker.setCutoff(30.0f);
+        stereoDcBlocker.setCutoff(30.0f);
     }
     
-    void setSampleRate(float sampleRate) {
+    void setSampleRate(float sampleRate) noexcept {
         this->sampleRate = sampleRate;
+        crossfadeStep = ONE / (CROSSFADE_TIME * sampleRate);
         feedbackDcBlocker.setSampleRate(sampleRate);
-        if (maxDelaySamples > 0) {
-            setMaxDelayTime(maxDelayTime);
-        }
+        stereoDcBlocker.setSampleRate(sampleRate);
+        setMaxDelayTime(maxDelayTime);
     }
     
-    void setMaxDelayTime(float maxTime) {
-        maxDelayTime = maxTime;
-        maxDelaySamples = static_cast<int>(maxTime * sampleRate) + 1;
-        buffer.resize(maxDelaySamples, ZERO);
-        writeIndex = 0;
+    // The setters are safe on any thread: process() applies the change.
+    void setLongMode(bool enabled) noexcept { requestedLong.store(enabled, std::memory_order_relaxed); }
+    [[nodiscard]] bool isLongMode() const noexcept { return requestedLong.load(std::memory_order_relaxed); }
+
+    void setMode(Mode mode) noexcept { requestedMode.store(mode, std::memory_order_relaxed); }
+    [[nodiscard]] Mode getMode() const noexcept { return requestedMode.load(std::memory_order_relaxed); }
+
+    void setStereo(Stereo stereo) noexcept { requestedStereo.store(stereo, std::memory_order_relaxed); }
+    [[nodiscard]] Stereo getStereo() const noexcept { return requestedStereo.load(std::memory_order_relaxed); }
+
+    // Not for the audio thread, and only ever from one thread (a worker). Allocates the line
+    // process() asked for, drops the line of the length that is no longer selected and frees
+    // whatever the audio thread has let go of. Until process() runs with a non-zero amount,
+    // nothing is allocated.
+    void allocate() {
+        bool longWanted = requestedLong.load(std::memory_order_relaxed);
+        if (longWanted) {
+            shortLine.drop();
+        } else {
+            longLine.drop();
+        }
+        if (lineWanted.exchange(false, std::memory_order_acquire)) {
+            uint32_t channels = requestedStereo.load(std::memory_order_relaxed) != Stereo::MONO ? 2u : 1u;
+            if (longWanted) {
+                longLine.grow(lineSize(LONG_DELAY_TIME), channels);
+            } else {
+                shortLine.grow(lineSize(MAX_DELAY_TIME), channels);
+            }
+        }
+        shortLine.collect();
+        longLine.collect();
     }
 
-    [[nodiscard]] float process(float input, float clockTrigger, float time, float amount) {
-        if (buffer.empty()) return input;
-        
+    [[nodiscard]] bool hasLine() const noexcept { return shortLine.allocated() || longLine.allocated(); }
+
+    // Lines replaced or dropped by allocate() that the audio thread may still be reading.
+    [[nodiscard]] size_t retainedLines() const noexcept { return shortLine.retainedLines() + longLine.retainedLines(); }
+
+    // Until its line is allocated the delay passes the input through dry.
+    [[nodiscard]] float process(float input, float clockTrigger, float time, float amount) noexcept {
+        applyRequests();
+        amount = std::clamp(amount, ZERO, ONE);
+        if (longMode) return processMono(longLine.acquire(), input, clockTrigger, time, amount);
+        return processMono(shortLine.acquire(), input, clockTrigger, time, amount);
+    }
+
+    // Both sides run through one float_4 kernel: lane 0 is left, lane 1 right.
+    [[nodiscard]] float_4 processStereo(float input, float clockTrigger, float time, float amount) noexcept {
+        applyRequests();
         amount = std::clamp(amount, ZERO, ONE);
+        if (amount <= ZERO || stereo == Stereo::MONO) {
+            float mono = process(input, clockTrigger, time, amount);
+            return float_4(mono, mono, ZERO, ZERO);
+        }
+        if (longMode) return processStereo(longLine.acquire(), input, clockTrigger, time, amount);
+        return processStereo(shortLine.acquire(), input, clockTrigger, time, amount);
+    }
+    
+    bool isClockConnected() const {
+        return static_cast<float>(samplesSinceLastClock) < sampleRate * std::max(TWO, maxDelayTime) && lastClockInterval > ZERO;
+    }
+    
+    // Only while the audio thread is not running, e.g. from onReset.
+    void clear() {
+        if (ShortLine* active = shortLine.current()) {
+            std::fill(active->samples.begin(), active->samples.end(), ZERO);
+        }
+        if (LongLine* active = longLine.current()) {
+            std::fill(active->samples.begin(), active->samples.end(), int16_t{0});
+        }
+        lastClockTrigger = ZERO;
+        samplesSinceLastClock = 0;
+        lastClockInterval = ZERO;
+        smoothedDelaySamples = TWO;
+        headDelaySamples = TWO;
+        crossfadePhase = ZERO;
+        feedbackDcBlocker.reset();
+        stereoDcBlocker.reset();
+    }
+    
+private:
+    LineSlot<ShortLine> shortLine;
+    LineSlot<LongLine> longLine;
+    std::atomic<bool> lineWanted{false};
+    std::atomic<bool> requestedLong{false};
+    std::atomic<Mode> requestedMode{Mode::TAPE};
+    std::atomic<Stereo> requestedStereo{Stereo::MONO};
+    bool longMode = false;
+    int maxDelaySamples = 0;
+    uint32_t writeIndex = 0;
+    float maxDelayTime = MAX_DELAY_TIME;
+    float sampleRate = 44100.0f;
+    float lastClockTrigger = ZERO;
+    int samplesSinceLastClock = 0;
+    float lastClockInterval = ZERO;
+    float smoothedDelaySamples = TWO;
+    Mode mode = Mode::TAPE;
+    Stereo stereo = Stereo::MONO;
+    float headDelaySamples = TWO;
+    float nextHeadDelaySamples = TWO;
+    float crossfadePhase = ZERO;
+    float crossfadeStep = ONE;
+    DcBlocker feedbackDcBlocker;
+    DcBlocker4 stereoDcBlocker;
+
+    // Above MAX_SAMPLE_RATE the longest delay shrinks to what the line can hold.
+    void setMaxDelayTime(float maxTime) noexcept {
+        maxDelayTime = std::clamp(maxTime, 0.001f, LONG_DELAY_TIME);
+        float samples = std::min(maxDelayTime * sampleRate + ONE, static_cast<float>(lineSize(maxDelayTime) - 1));
+        maxDelaySamples = std::max(static_cast<int>(samples), 2);
+        smoothedDelaySamples = std::min(smoothedDelaySamples, static_cast<float>(maxDelaySamples - 1));
+        headDelaySamples = std::min(headDelaySamples, static_cast<float>(maxDelaySamples - 1));
+        nextHeadDelaySamples = std::min(nextHeadDelaySamples, static_cast<float>(maxDelaySamples - 1));
+    }
+
+    // Adopts the settings requested through the setters.
+    void applyRequests() noexcept {
+        bool longRequested = requestedLong.load(std::memory_order_relaxed);
+        if (longRequested != longMode) {
+            longMode = longRequested;
+            if (longMode) {
+                shortLine.release();
+            } else {
+                longLine.release();
+            }
+            setMaxDelayTime(longMode ? LONG_DELAY_TIME : MAX_DELAY_TIME);
+        }
+
+        Mode modeRequested = requestedMode.load(std::memory_order_relaxed);
+        if (modeRequested != mode) {
+            mode = modeRequested;
+            if (mode == Mode::DIGITAL) {
+                headDelaySamples = smoothedDelaySamples;
+            } else {
+                smoothedDelaySamples = headDelaySamples;
+            }
+            crossfadePhase = ZERO;
+        }
+
+        Stereo stereoRequested = requestedStereo.load(std::memory_order_relaxed);
+        if (stereoRequested != stereo) {
+            stereo = stereoRequested;
+            stereoDcBlocker.reset();
+        }
+    }
+
+    template <typename L>
+    [[nodiscard]] float processMono(L* active, float input, float clockTrigger, float time, float amount) noexcept {
         if (amount <= ZERO) return input;
-        
+        if (!active) {
+            lineWanted.store(true, std::memory_order_release);
+            return input;
+        }
+
         input = std::clamp(input, -10.0f, 10.0f);
+        float maxSamples = maxReadSamples(*active);
+        float targetDelaySamples = targetSamples(clockTrigger, time, maxSamples);
+        float delayedSample = readHeads(targetDelaySamples, maxSamples, [&](float delaySamples) {
+            return readHermite(*active, delaySamples);
+        });
+        float feedback = amount * 0.4f;
+        
+        float feedbackSignal = feedbackDcBlocker.process(delayedSample * feedback);
+        feedbackSignal = std::clamp(feedbackSignal, -TWO, TWO);
         
+        active->write(writeIndex, 0, input + feedbackSignal);
+        writeIndex = (writeIndex + 1) & active->mask;
+        return input * (ONE - amount) + delayedSample * amount;
+    }
+
+    template <typename L>
+    [[nodiscard]] float_4 processStereo(L* active, float input, float clockTrigger, float time, float amount) noexcept {
+        if (!active || active->channels < 2) {
+            lineWanted.store(true, std::memory_order_release);
+            return float_4(input, input, ZERO, ZERO);
+        }
+
+        input = std::clamp(input, -10.0f, 10.0f);
+        float maxSamples = maxReadSamples(*active);
+        float targetDelaySamples = targetSamples(clockTrigger, time, maxSamples);
+        float spreadSamples = stereo == Stereo::SPREAD ? SPREAD_TIME * sampleRate : ZERO;
+        float_4 delayed = readHeads(targetDelaySamples, maxSamples, [&](float delaySamples) {
+            return readHermiteStereo(*active, delaySamples, std::min(delaySamples + spreadSamples, maxSamples));
+        });
+        float_4 feedback = stereoDcBlocker.process(delayed * (amount * 0.4f));
+        feedback = rack::simd::clamp(feedback, -TWO, TWO);
+
+        float writeLeft = input;
+        float writeRight = input;
+        if (stereo == Stereo::PING_PONG) {
+            writeLeft += feedback[1];
+            writeRight = feedback[0];
+        } else {
+            writeLeft += feedback[0];
+            writeRight += feedback[1];
+        }
+        active->write(writeIndex, 0, writeLeft);
+        active->write(writeIndex, 1, writeRight);
+        writeIndex = (writeIndex + 1) & active->mask;
+        return float_4(input * (ONE - amount)) + delayed * amount;
+    }
+
+    // The Hermite read needs one newer and two older neighbours around the read position.
+    template <typename L>
+    [[nodiscard]] float maxReadSamples(const L& active) const noexcept {
+        return static_cast<float>(std::min(maxDelaySamples - 1, static_cast<int>(active.mask) - 2));
+    }
+
+    [[nodiscard]] float targetSamples(float clockTrigger, float time, float maxSamples) noexcept {
         bool clockTriggered = clockTrigger > ONE && lastClockTrigger <= ONE;
         lastClockTrigger = clockTrigger;
         
         float delayTime;
+        float clockTimeout = sampleRate * std::max(TWO, maxDelayTime);
         
         if (clockTriggered) {
             float measuredTime = static_cast<float>(samplesSinceLastClock) / sampleRate;
-            if (measuredTime > MIN && measuredTime < 4.0f) {
+            if (measuredTime > MIN && measuredTime < std::max(4.0f, maxDelayTime)) {
                 lastClockInterval = measuredTime;
             }
             samplesSinceLastClock = 0;
@@ -52,59 +369,74 @@ public:
             samplesSinceLastClock++;
         }
         
-        if (clockTrigger > 0.1f && static_cast<float>(samplesSinceLastClock) < sampleRate * TWO && lastClockInterval > ZERO) {
+        if (clockTrigger > 0.1f && static_cast<float>(samplesSinceLastClock) < clockTimeout && lastClockInterval > ZERO) {
             delayTime = lastClockInterval;
         } else {
-            delayTime = MIN + time * 1.99f;
+            delayTime = MIN + time * (maxDelayTime - MIN);
         }
         
         delayTime = std::clamp(delayTime, 0.001f, maxDelayTime);
-        float targetDelaySamples = delayTime * sampleRate;
-        targetDelaySamples = std::clamp(targetDelaySamples, ONE, static_cast<float>(maxDelaySamples - 1));
-        smoothedDelaySamples += (targetDelaySamples - smoothedDelaySamples) * MIN;
-        int delaySamples = static_cast<int>(smoothedDelaySamples);
-        float fraction = smoothedDelaySamples - static_cast<float>(delaySamples);
-        int readIndex1 = writeIndex - delaySamples;
-        int readIndex2 = writeIndex - delaySamples - 1;
-        if (readIndex1 < 0) readIndex1 += maxDelaySamples;
-        if (readIndex2 < 0) readIndex2 += maxDelaySamples;
-        float sample1 = buffer[static_cast<size_t>(readIndex1)];
-        float sample2 = buffer[static_cast<size_t>(readIndex2)];
-        float delayedSample = sample1 + fraction * (sample2 - sample1);
-        float feedback = amount * 0.4f;
-        
-        float feedbackSignal = feedbackDcBlocker.process(delayedSample * feedback);
-        feedbackSignal = std::clamp(feedbackSignal, -TWO, TWO);
-        
-        buffer[writeIndex] = input + feedbackSignal;
-        writeIndex = (writeIndex + 1) % maxDelaySamples;
-        return input * (ONE - amount) + delayedSample * amount;
+        return std::clamp(delayTime * sampleRate, TWO, maxSamples);
     }
-    
-    bool isClockConnected() const {
-        return static_cast<float>(samplesSinceLastClock) < sampleRate * TWO && lastClockInterval > ZERO;
+
+    // 4-point, 3rd-order Hermite on one tap set; works on floats and on float_4 lanes alike.
+    template <typename T>
+    [[nodiscard]] static T hermite(T xm1, T x0, T x1, T x2, T t) noexcept {
+        T c1 = HALF * (x1 - xm1);
+        T c2 = xm1 - 2.5f * x0 + TWO * x1 - HALF * x2;
+        T c3 = HALF * (x2 - xm1) + 1.5f * (x0 - x1);
+        return ((c3 * t + c2) * t + c1) * t + x0;
     }
-    
-    void clear() {
-        std::fill(buffer.begin(), buffer.end(), ZERO);
-        lastClockTrigger = ZERO;
-        samplesSinceLastClock = 0;
-        lastClockInterval = ZERO;
-        smoothedDelaySamples = ONE;
-        feedbackDcBlocker.reset();
+
+    // Fractional read of channel 0 at a delay of at least two samples.
+    template <typename L>
+    [[nodiscard]] float readHermite(const L& active, float delaySamples) const noexcept {
+        auto whole = static_cast<uint32_t>(delaySamples);
+        uint32_t index = writeIndex - whole;
+        return hermite(active.at(index + 1, 0), active.at(index, 0), active.at(index - 1, 0), active.at(index - 2, 0),
+            delaySamples - static_cast<float>(whole));
+    }
+
+    template <typename L>
+    [[nodiscard]] float_4 readHermiteStereo(const L& active, float delayLeft, float delayRight) const noexcept {
+        auto wholeLeft = static_cast<uint32_t>(delayLeft);
+        auto wholeRight = static_cast<uint32_t>(delayRight);
+        uint32_t left = writeIndex - wholeLeft;
+        uint32_t right = writeIndex - wholeRight;
+        return hermite(
+            float_4(active.at(left + 1, 0), active.at(right + 1, 1), ZERO, ZERO),
+            float_4(active.at(left, 0), active.at(right, 1), ZERO, ZERO),
+            float_4(active.at(left - 1, 0), active.at(right - 1, 1), ZERO, ZERO),
+            float_4(active.at(left - 2, 0), active.at(right - 2, 1), ZERO, ZERO),
+            float_4(delayLeft - static_cast<float>(wholeLeft), delayRight - static_cast<float>(wholeRight), ZERO, ZERO));
+    }
+
+    // Tape mode glides one head; digital mode crossfades to a second head when the time changes,
+    // and changes during a crossfade wait for it to finish.
+    template <typename Read>
+    [[nodiscard]] std::invoke_result_t<Read, float> readHeads(float targetDelaySamples, float maxSamples, Read read) noexcept {
+        if (mode == Mode::TAPE) {
+            smoothedDelaySamples += (targetDelaySamples - smoothedDelaySamples) * MIN;
+            smoothedDelaySamples = std::clamp(smoothedDelaySamples, TWO, maxSamples);
+            return read(smoothedDelaySamples);
+        }
+        headDelaySamples = std::clamp(headDelaySamples, TWO, maxSamples);
+        if (crossfadePhase <= ZERO && std::abs(targetDelaySamples - headDelaySamples) > HALF) {
+            nextHeadDelaySamples = targetDelaySamples;
+            crossfadePhase = crossfadeStep;
+        }
+        auto out = read(headDelaySamples);
+        if (crossfadePhase > ZERO) {
+            nextHeadDelaySamples = std::clamp(nextHeadDelaySamples, TWO, maxSamples);
+            out += (read(nextHeadDelaySamples) - out) * crossfadePhase;
+            crossfadePhase += crossfadeStep;
+            if (crossfadePhase >= ONE) {
+                headDelaySamples = nextHeadDelaySamples;
+                crossfadePhase = ZERO;
+            }
+        }
+        return out;
     }
-    
-private:
-    std::vector<float> buffer;
-    int maxDelaySamples = 0;
-    int writeIndex = 0;
-    float maxDelayTime = TWO;
-    float sampleRate = 44100.0f;
-    float lastClockTrigger = ZERO;
-    int samplesSinceLastClock = 0;
-    float lastClockInterval = ZERO;
-    float smoothedDelaySamples = ONE;
-    DcBlocker feedbackDcBlocker;
 };
 
-}
\ No newline at end of file
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <cstdint>
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define CLONOTRIBE_DENORMALS_SSE 1
+#endif
+
+namespace clonotribe {
+
+// Scoped flush-to-zero / denormals-are-zero, replacing hand-written "abs(x) < 1e-30" flushes
+// in the DSP loops. Rack already sets both on its engine threads, so inside the module this
+// is one status register read; the register is only written, and restored on exit, when a
+// thread runs without them (tests, other hosts).
+class DenormalGuard final {
+public:
+    DenormalGuard() noexcept {
+        saved = read();
+        changed = (saved & FLAGS) != FLAGS;
+        if (changed) write(saved | FLAGS);
+    }
+
+    ~DenormalGuard() {
+        if (changed) write(saved);
+    }
+
+    DenormalGuard(const DenormalGuard&) = delete;
+    DenormalGuard& operator=(const DenormalGuard&) = delete;
+
+    [[nodiscard]] static bool isActive() noexcept {
+        return (read() & FLAGS) == FLAGS;
+    }
+
+private:
+#if defined(CLONOTRIBE_DENORMALS_SSE)
+    using Register = unsigned int;
+    static constexpr Register FLAGS = 0x8040; // FTZ | DAZ
+    static Register read() noexcept { return _mm_getcsr(); }
+    static void write(Register value) noexcept { _mm_setcsr(value); }
+#elif defined(__aarch64__)
+    using Register = uint64_t;
+    static constexpr Register FLAGS = Register{1} << 24; // FPCR.FZ covers inputs and outputs
+    static Register read() noexcept {
+        Register value;
+        __asm__ __volatile__("mrs %0, fpcr" : "=r"(value));
+        return value;
+    }
+    static void write(Register value) noexcept { __asm__ __volatile__("msr fpcr, %0" : : "r"(value)); }
+#else
+    using Register = uint32_t;
+    static constexpr Register FLAGS = 0;
+    static Register read() noexcept { return 0; }
+    static void write(Register) noexcept {}
+#endif
+
+    Register saved = 0;
+    bool changed = false;
+};
+}
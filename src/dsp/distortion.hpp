@@ -1,26 +1,65 @@
 #pragma once
+#include <algorithm>
+#include <array>
 #include <cmath>
 #include "fastmath.hpp"
+#include "shared_table.hpp"
+#include "simd.hpp"
 
 namespace clonotribe {
 
 class Distortion {
 public:
+    // CLASSIC evaluates the waveshaper directly; ADAA uses its first-order antiderivative
+    // to suppress the aliasing the high drive produces.
+    enum class Algorithm { CLASSIC, ADAA };
+
     Distortion() {
         reset();
     }
     
     void reset() {
         lowpass = ZERO;
+        adaaPrimed = false;
+    }
+
+    void setAlgorithm(Algorithm algorithm) noexcept {
+        if (algorithm == this->algorithm) return;
+        this->algorithm = algorithm;
+        adaaPrimed = false;
+    }
+
+    [[nodiscard]] Algorithm getAlgorithm() const noexcept { return algorithm; }
+
+    // Running at factor x the host rate; keeps the internal lowpass corner where it was.
+    void setOversampling(int factor) noexcept {
+        oversampling = std::max(factor, 1);
+        cachedAmount = -ONE;
     }
     
     [[nodiscard]] float process(float input, float amount) {
         if (amount <= ZERO) {
+            adaaPrimed = false;
             return input;
         }
         
         float driven = input * (ONE + amount * DRIVE_SCALE);
+        driven = algorithm == Algorithm::ADAA ? shapeAdaa(driven, amount) : shaper->lookup(driven, amount);
+        
+        float filterCutoff = lowpassCoefficient(amount);
+        lowpass = lowpass * (ONE - filterCutoff) + driven * filterCutoff; // Improved filter
+        
+        float highFreq = driven - lowpass;
+        float output = lowpass + FastMath::fastTanh(highFreq * HIGH_SATURATION_SCALE) * HIGH_MIX * amount;
         
+        output = FastMath::fastTanh(output * FINAL_SATURATION_SCALE) * FINAL_GAIN;
+        
+        float compressionAmount = COMPRESSION_BASE / (ONE + amount * COMPRESSION_SCALE);
+        return output * compressionAmount;
+    }
+
+    // Memoryless part of the distortion: saturation, asymmetric knee and DC compensation.
+    [[nodiscard]] static float shape(float driven, float amount) noexcept {
         driven = FastMath::fastTanh(driven * 1.2f) * 0.8f;
         
         if (driven > THRESHOLD) {
@@ -32,20 +71,86 @@ public:
         float dcCompensation = (POSITIVE_CLIPPING_THRESHOLD - NEGATIVE_CLIPPING_FACTOR) * amount * 0.1f;
         driven -= dcCompensation;
         
-        driven = FastMath::fastTanh(FastMath::fastTanh(driven * TWO) * 0.7f * 2.5f) * 0.6f;
-        
-        float filterCutoff = FILTER_BASE - amount * FILTER_SCALE;
-        lowpass = lowpass * (ONE - filterCutoff) + driven * filterCutoff; // Improved filter
-        
-        float highFreq = driven - lowpass;
-        float output = lowpass + FastMath::fastTanh(highFreq * HIGH_SATURATION_SCALE) * HIGH_MIX * amount;
-        
-        output = FastMath::fastTanh(output * FINAL_SATURATION_SCALE) * FINAL_GAIN;
-        
-        float compressionAmount = COMPRESSION_BASE / (ONE + amount * COMPRESSION_SCALE);
-        return output * compressionAmount;
+        return FastMath::fastTanh(FastMath::fastTanh(driven * TWO) * 0.7f * 2.5f) * 0.6f;
     }
 
+    // shape() and its antiderivative tabulated over the driven input for a few amounts, shared
+    // by all instances through SharedTable. lookup() reads shape() bilinearly; the antiderivative
+    // is interpolated with cubic Hermite segments using shape() itself as the slope. Beyond RANGE
+    // the first tanh is saturated, so shape() is held and the antiderivative continues linearly.
+    struct alignas(64) ShaperTable final {
+        static constexpr int SLICES = 9;
+        static constexpr int POINTS = 2049;
+        static constexpr float RANGE = 2.5f;
+        static constexpr float STEP = TWO * RANGE / static_cast<float>(POINTS - 1);
+
+        std::array<std::array<float, POINTS>, SLICES> integral{};
+        std::array<std::array<float, POINTS>, SLICES> slope{};
+        // One cell per (slice pair, interval): {lower[k], lower[k+1] - lower[k], upper[k], upper[k+1] - upper[k]}.
+        std::array<float_4, (SLICES - 1) * (POINTS - 1)> cells{};
+
+        ShaperTable() noexcept {
+            for (int s = 0; s < SLICES; ++s) {
+                float amount = static_cast<float>(s) / static_cast<float>(SLICES - 1);
+                auto& f = integral[static_cast<size_t>(s)];
+                auto& d = slope[static_cast<size_t>(s)];
+                double sum = 0.0;
+                for (int i = 0; i < POINTS; ++i) {
+                    float u = -RANGE + STEP * static_cast<float>(i);
+                    d[static_cast<size_t>(i)] = shape(u, amount);
+                    if (i > 0) {
+                        // Simpson's rule on each interval.
+                        float mid = shape(u - HALF * STEP, amount);
+                        sum += static_cast<double>(STEP) / 6.0 * (d[static_cast<size_t>(i - 1)] + 4.0 * mid + d[static_cast<size_t>(i)]);
+                    }
+                    f[static_cast<size_t>(i)] = static_cast<float>(sum);
+                }
+            }
+            for (size_t s = 0; s + 1 < SLICES; ++s) {
+                const auto& lower = slope[s];
+                const auto& upper = slope[s + 1];
+                for (size_t k = 0; k + 1 < POINTS; ++k) {
+                    cells[s * (POINTS - 1) + k] = float_4(lower[k], lower[k + 1] - lower[k], upper[k], upper[k + 1] - upper[k]);
+                }
+            }
+        }
+
+        // Bilinear read of shape(): one cell load, weighted by {1 - a, (1 - a) t, a, a t}.
+        [[nodiscard]] float lookup(float u, float amount) const noexcept {
+            float position = std::clamp(amount, ZERO, ONE) * static_cast<float>(SLICES - 1);
+            int s = std::min(static_cast<int>(position), SLICES - 2);
+            float a = position - static_cast<float>(s);
+            float x = std::clamp((u + RANGE) / STEP, ZERO, static_cast<float>(POINTS - 1));
+            int k = std::min(static_cast<int>(x), POINTS - 2);
+            float t = x - static_cast<float>(k);
+            float_4 weighted = cells[static_cast<size_t>(s * (POINTS - 1) + k)] * float_4(ONE - a, (ONE - a) * t, a, a * t);
+            return (weighted[0] + weighted[1]) + (weighted[2] + weighted[3]);
+        }
+
+        [[nodiscard]] float antiderivative(float u, float amount) const noexcept {
+            float position = std::clamp(amount, ZERO, ONE) * static_cast<float>(SLICES - 1);
+            int s = std::min(static_cast<int>(position), SLICES - 2);
+            float t = position - static_cast<float>(s);
+            float lower = evaluate(s, u);
+            return lower + t * (evaluate(s + 1, u) - lower);
+        }
+
+    private:
+        [[nodiscard]] float evaluate(int s, float u) const noexcept {
+            const auto& f = integral[static_cast<size_t>(s)];
+            const auto& d = slope[static_cast<size_t>(s)];
+            if (u <= -RANGE) return f.front() + d.front() * (u + RANGE);
+            if (u >= RANGE) return f.back() + d.back() * (u - RANGE);
+            float x = (u + RANGE) / STEP;
+            auto k = std::min(static_cast<size_t>(x), static_cast<size_t>(POINTS - 2));
+            float t = x - static_cast<float>(k);
+            float t2 = t * t;
+            float t3 = t2 * t;
+            return (TWO * t3 - 3.0f * t2 + ONE) * f[k] + (t3 - TWO * t2 + t) * STEP * d[k]
+                + (3.0f * t2 - TWO * t3) * f[k + 1] + (t3 - t2) * STEP * d[k + 1];
+        }
+    };
+
 private:
     static constexpr float DRIVE_SCALE = 50.0f;
     static constexpr float THRESHOLD = 0.4f;
@@ -59,7 +164,42 @@ private:
     static constexpr float FINAL_GAIN = 0.4f;
     static constexpr float COMPRESSION_BASE = 0.8f;
     static constexpr float COMPRESSION_SCALE = 0.1f;
+    static constexpr float ADAA_EPSILON = 1e-3f;
 
+    SharedTable<ShaperTable> shaper;
     float lowpass = ZERO;    
+    Algorithm algorithm = Algorithm::CLASSIC;
+    float previousDriven = ZERO;
+    bool adaaPrimed = false;
+    int oversampling = 1;
+    float cachedAmount = -ONE;
+    float cachedCoefficient = ONE;
+
+    [[nodiscard]] float lowpassCoefficient(float amount) noexcept {
+        float coefficient = FILTER_BASE - amount * FILTER_SCALE;
+        if (oversampling == 1) return coefficient;
+        if (amount != cachedAmount) {
+            cachedAmount = amount;
+            cachedCoefficient = ONE - std::pow(ONE - coefficient, ONE / static_cast<float>(oversampling));
+        }
+        return cachedCoefficient;
+    }
+
+    // First-order ADAA: the average of shape() over the segment between consecutive inputs.
+    [[nodiscard]] float shapeAdaa(float driven, float amount) noexcept {
+        if (!adaaPrimed) {
+            previousDriven = driven;
+            adaaPrimed = true;
+        }
+        float delta = driven - previousDriven;
+        float out;
+        if (std::abs(delta) < ADAA_EPSILON) {
+            out = shaper->lookup(HALF * (driven + previousDriven), amount);
+        } else {
+            out = (shaper->antiderivative(driven, amount) - shaper->antiderivative(previousDriven, amount)) / delta;
+        }
+        previousDriven = driven;
+        return out;
+    }
 };
-}
\ No newline at end of file
+}
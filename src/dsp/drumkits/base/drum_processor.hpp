@@ -58,7 +58,8 @@ public:
         hihatLatin.reset();
     }
     
-    void triggerKick() {
+    void triggerKick(float accent = ZERO) {
+        kickAccent = accent;
         switch (currentKit) {
             case DrumKitType::TR808: kickTR808.reset(); break;
             case DrumKitType::LATIN: kickLatin.reset(); break;
@@ -66,7 +67,8 @@ public:
         }
     }
     
-    void triggerSnare() {
+    void triggerSnare(float accent = ZERO) {
+        snareAccent = accent;
         switch (currentKit) {
             case DrumKitType::TR808: snareTR808.reset(); break;
             case DrumKitType::LATIN: snareLatin.reset(); break;
@@ -74,7 +76,8 @@ public:
         }
     }
     
-    void triggerHihat() {
+    void triggerHihat(float accent = ZERO) {
+        hihatAccent = accent;
         switch (currentKit) {
             case DrumKitType::TR808: hihatTR808.reset(); break;
             case DrumKitType::LATIN: hihatLatin.reset(); break;
@@ -83,6 +86,7 @@ public:
     }
     
     float processKick(float trig, float accent, NoiseGenerator& noise) {
+        accent = std::max(accent, kickAccent);
         switch (currentKit) {
             case DrumKitType::TR808: return kickTR808.process(trig, accent, noise);
             case DrumKitType::LATIN: return kickLatin.process(trig, accent, noise);
@@ -91,6 +95,7 @@ public:
     }
     
     float processSnare(float trig, float accent, NoiseGenerator& noise) {
+        accent = std::max(accent, snareAccent);
         switch (currentKit) {
             case DrumKitType::TR808: return snareTR808.process(trig, accent, noise);
             case DrumKitType::LATIN: return snareLatin.process(trig, accent, noise);
@@ -99,6 +104,7 @@ public:
     }
     
     float processHihat(float trig, float accent, NoiseGenerator& noise) {
+        accent = std::max(accent, hihatAccent);
         switch (currentKit) {
             case DrumKitType::TR808: return hihatTR808.process(trig, accent, noise);
             case DrumKitType::LATIN: return hihatLatin.process(trig, accent, noise);
@@ -109,6 +115,9 @@ public:
 private:
     DrumKitType currentKit = DrumKitType::ORIGINAL;
     float currentSampleRate = 44100.0f;
+    float kickAccent = ZERO;
+    float snareAccent = ZERO;
+    float hihatAccent = ZERO;
     
     drumkits::original::KickDrum kickOriginal;
     drumkits::original::SnareDrum snareOriginal;
@@ -1,6 +1,7 @@
 #pragma once
 #include "../../fastmath.hpp"
 #include "../../noise.hpp"
+#include "../../rate_coefficient.hpp"
 #include "../base/base.hpp"
 
 namespace drumkits {
@@ -24,6 +25,7 @@ public:
     
     void setSampleRate(float newSampleRate) override {
         sampleRate = newSampleRate;
+        clonotribe::rescale(sampleRate, envDecay, shimmerDecay, hpCutoff, bp1Cutoff, bp2Cutoff);
     }
     
     [[nodiscard]] float process(float trig, float accent, clonotribe::NoiseGenerator& noise) override {
@@ -55,21 +57,21 @@ public:
         float metallicSum = metallic1 + metallic2 + shimmer;
         float rawNoise = noise.process();
         
-        highpassState += (rawNoise - highpassState) * HP_CUTOFF;
+        highpassState += (rawNoise - highpassState) * hpCutoff;
         float brightNoise = (rawNoise - highpassState) * env;
         
-        bandpass1State1 += (brightNoise - bandpass1State1) * BP1_CUTOFF;
-        bandpass1State2 += (bandpass1State1 - bandpass1State2) * BP1_CUTOFF;
+        bandpass1State1 += (brightNoise - bandpass1State1) * bp1Cutoff;
+        bandpass1State2 += (bandpass1State1 - bandpass1State2) * bp1Cutoff;
         float bp1Out = bandpass1State1 - bandpass1State2;
         
-        bandpass2State1 += (bp1Out - bandpass2State1) * BP2_CUTOFF;
-        bandpass2State2 += (bandpass2State1 - bandpass2State2) * BP2_CUTOFF;
+        bandpass2State1 += (bp1Out - bandpass2State1) * bp2Cutoff;
+        bandpass2State2 += (bandpass2State1 - bandpass2State2) * bp2Cutoff;
         float bp2Out = bandpass2State1 - bandpass2State2;
         
         float output = metallicSum * 0.55f + bp2Out * 0.85f;
 
-        env *= 0.9890f;
-        shimmerEnv *= 0.9940f;
+        env *= envDecay;
+        shimmerEnv *= shimmerDecay;
 
         if (env < 0.001f && shimmerEnv < 0.001f) {
             triggered = false;
@@ -83,9 +85,6 @@ private:
     static constexpr float FREQ1 = 2300.0f;
     static constexpr float FREQ2 = 4000.0f;
     static constexpr float FREQ3 = 7200.0f;
-    static constexpr float HP_CUTOFF = 0.27f;
-    static constexpr float BP1_CUTOFF = 0.38f;
-    static constexpr float BP2_CUTOFF = 0.48f;
 
     float env = ZERO;
     float shimmerEnv = ZERO;
@@ -98,6 +97,11 @@ private:
     float bandpass2State2 = ZERO;
     float highpassState = ZERO;
     float sampleRate = 44100.0f;
+    clonotribe::Decay envDecay{0.9890f};
+    clonotribe::Decay shimmerDecay{0.9940f};
+    clonotribe::OnePole hpCutoff{0.27f};
+    clonotribe::OnePole bp1Cutoff{0.38f};
+    clonotribe::OnePole bp2Cutoff{0.48f};
     bool triggered = false;
 };
 }
@@ -1,6 +1,7 @@
 #pragma once
 #include "../../fastmath.hpp"
 #include "../../noise.hpp"
+#include "../../rate_coefficient.hpp"
 #include "../base/base.hpp"
 
 namespace drumkits {
@@ -20,6 +21,7 @@ public:
     
     void setSampleRate(float newSampleRate) override {
         sampleRate = newSampleRate;
+        clonotribe::rescale(sampleRate, pitchDecay, ampDecay, clickDecay, hpCutoff);
     }
     
     [[nodiscard]] float process(float trig, float accent, clonotribe::NoiseGenerator& noise) override {
@@ -47,14 +49,14 @@ public:
         
         float n = noise.process();
         
-        hpState += (n - hpState) * HP_CUTOFF;
+        hpState += (n - hpState) * hpCutoff;
         float hpNoise = n - hpState;
         float click = (clickEnv > 0.7f ? (clickEnv - 0.7f) * 3.33f : ZERO) + hpNoise * 0.1f * clickEnv;        
         float output = (mainSine + lowSine + click * 0.4f) * ampEnv;
         
-        pitchEnv *= 0.9986f;
-        ampEnv *= 0.9978f;
-        clickEnv *= 0.987f;
+        pitchEnv *= pitchDecay;
+        ampEnv *= ampDecay;
+        clickEnv *= clickDecay;
         
         if (ampEnv < 0.001f) {
             triggered = false;
@@ -65,7 +67,6 @@ public:
     }
     
 private:
-    static constexpr float HP_CUTOFF = 0.28f;
 
     float pitchEnv = ZERO;
     float ampEnv = ZERO;
@@ -74,6 +75,10 @@ private:
     float lowPhase = ZERO;
     float hpState = ZERO;
     float sampleRate = 44100.0f;
+    clonotribe::Decay pitchDecay{0.9986f};
+    clonotribe::Decay ampDecay{0.9978f};
+    clonotribe::Decay clickDecay{0.987f};
+    clonotribe::OnePole hpCutoff{0.28f};
     bool triggered = false;
 };
 }
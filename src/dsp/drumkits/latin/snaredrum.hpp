@@ -1,6 +1,7 @@
 #pragma once
 #include "../../fastmath.hpp"
 #include "../../noise.hpp"
+#include "../../rate_coefficient.hpp"
 #include "../base/base.hpp"
 
 namespace drumkits {
@@ -23,6 +24,7 @@ public:
     
     void setSampleRate(float newSampleRate) override {
         sampleRate = newSampleRate;
+        clonotribe::rescale(sampleRate, toneDecay, noiseDecay, crackleDecay, ampDecay, hpCutoff, bpCutoff, crackleCutoff);
     }
     
     [[nodiscard]] float process(float trig, float accent, clonotribe::NoiseGenerator& noise) override {
@@ -41,21 +43,21 @@ public:
         float tone = clonotribe::FastMath::fastSin(tonePhase) * toneEnv;
         float rawNoise = noise.process();
         
-        highpassState += (rawNoise - highpassState) * HP_CUTOFF;
+        highpassState += (rawNoise - highpassState) * hpCutoff;
         float brightNoise = (rawNoise - highpassState) * noiseEnv;
 
-        bandpassState1 += (brightNoise - bandpassState1) * BP_CUTOFF;
-        bandpassState2 += (bandpassState1 - bandpassState2) * BP_CUTOFF;
+        bandpassState1 += (brightNoise - bandpassState1) * bpCutoff;
+        bandpassState2 += (bandpassState1 - bandpassState2) * bpCutoff;
         float crackNoise = (bandpassState1 - bandpassState2) * cracklEnv;
         
-        crackleFilter += (crackNoise - crackleFilter) * CRACKLE_CUTOFF;
+        crackleFilter += (crackNoise - crackleFilter) * crackleCutoff;
         float textureNoise = crackleFilter;        
         float output = tone * 0.2f + brightNoise * 0.55f + crackNoise * 0.75f + textureNoise * 0.25f;
 
-        toneEnv *= 0.9945f;
-        noiseEnv *= 0.9875f;
-        cracklEnv *= 0.9915f;
-        ampEnv *= 0.9905f;
+        toneEnv *= toneDecay;
+        noiseEnv *= noiseDecay;
+        cracklEnv *= crackleDecay;
+        ampEnv *= ampDecay;
         
         if (ampEnv < 0.001f) {
             triggered = false;
@@ -68,9 +70,6 @@ public:
     
 private:
     static constexpr float FREQ = 300.0f;
-    static constexpr float HP_CUTOFF = 0.14f;
-    static constexpr float BP_CUTOFF = 0.22f;
-    static constexpr float CRACKLE_CUTOFF = 0.38f;
 
     float ampEnv = ZERO;
     float toneEnv = ZERO;
@@ -82,6 +81,13 @@ private:
     float bandpassState2 = ZERO;
     float crackleFilter = ZERO;
     float sampleRate = 44100.0f;
+    clonotribe::Decay toneDecay{0.9945f};
+    clonotribe::Decay noiseDecay{0.9875f};
+    clonotribe::Decay crackleDecay{0.9915f};
+    clonotribe::Decay ampDecay{0.9905f};
+    clonotribe::OnePole hpCutoff{0.14f};
+    clonotribe::OnePole bpCutoff{0.22f};
+    clonotribe::OnePole crackleCutoff{0.38f};
     bool triggered = false;
 };
 }
@@ -1,6 +1,7 @@
 #pragma once
 #include "../../fastmath.hpp"
 #include "../../noise.hpp"
+#include "../../rate_coefficient.hpp"
 #include "../base/base.hpp"
 
 namespace drumkits {
@@ -23,6 +24,7 @@ public:
     
     void setSampleRate(float newSampleRate) override {
         sampleRate = newSampleRate;
+        clonotribe::rescale(sampleRate, envDecay, shimmerDecay, hpCutoff, bpCutoff);
     }
     
     [[nodiscard]] float process(float trig, float accent, clonotribe::NoiseGenerator& noise) override {
@@ -60,16 +62,16 @@ public:
         float metallicSum = metallic1 + metallic2 + metallic3 + metallic4;
         float rawNoise = noise.process();
         
-        highpass += (rawNoise - highpass) * HP_CUTOFF;
+        highpass += (rawNoise - highpass) * hpCutoff;
         float brightNoise = (rawNoise - highpass) * env;
         
-        bandpass1 += (brightNoise - bandpass1) * BP_CUTOFF;
-        bandpass2 += (bandpass1 - bandpass2) * BP_CUTOFF;
+        bandpass1 += (brightNoise - bandpass1) * bpCutoff;
+        bandpass2 += (bandpass1 - bandpass2) * bpCutoff;
         float filteredNoise = bandpass1 - bandpass2;        
         float output = metallicSum * 0.55f + filteredNoise * 0.75f;
 
-        env *= 0.9895f;
-        shimmerEnv *= 0.9925f;
+        env *= envDecay;
+        shimmerEnv *= shimmerDecay;
 
         if (env < 0.001f && shimmerEnv < 0.001f) {
             triggered = false;
@@ -80,8 +82,6 @@ public:
     }
     
 private:
-    static constexpr float HP_CUTOFF = 0.2f;
-    static constexpr float BP_CUTOFF = 0.32f;
     static constexpr float FREQ1 = 7200.0f;
     static constexpr float FREQ2 = 8800.0f;
     static constexpr float FREQ3 = 11200.0f;
@@ -97,6 +97,10 @@ private:
     float bandpass2 = ZERO;
     float highpass = ZERO;
     float sampleRate = 44100.0f;
+    clonotribe::Decay envDecay{0.9895f};
+    clonotribe::Decay shimmerDecay{0.9925f};
+    clonotribe::OnePole hpCutoff{0.2f};
+    clonotribe::OnePole bpCutoff{0.32f};
     bool triggered = false;
 };
 }
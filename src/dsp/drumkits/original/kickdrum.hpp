@@ -1,6 +1,7 @@
 #pragma once
 #include "../../fastmath.hpp"
 #include "../../noise.hpp"
+#include "../../rate_coefficient.hpp"
 #include "../base/base.hpp"
 
 namespace drumkits {
@@ -21,6 +22,8 @@ public:
     
     void setSampleRate(float newSampleRate) override {
         sampleRate = newSampleRate;
+        clonotribe::rescale(sampleRate, pitchDecay, ampDecay, subDecay, clickDecay, hpCutoff);
+        ampDecayJitter = 0.0001f * clonotribe::Decay::REFERENCE_RATE / sampleRate;
     }
     
     [[nodiscard]] float process(float trig, float accent, clonotribe::NoiseGenerator& noise) override {
@@ -50,16 +53,16 @@ public:
         
         float n = noise.process();
         
-        hpNoiseState += (n - hpNoiseState) * HP_CUTOFF;
+        hpNoiseState += (n - hpNoiseState) * hpCutoff;
         float hpNoise = n - hpNoiseState;
         float click = (clickEnv > 0.85f ? (clickEnv - 0.85f) * 6.67f : ZERO) + hpNoise * 0.12f * clickEnv;
         float output = (mainSine * ampEnv + subSine + click * 0.25f);        
-        float envDecay = 0.9983f + noise.process() * 0.0001f;
+        float envDecay = ampDecay + noise.process() * ampDecayJitter;
         
-        pitchEnv *= 0.9988f;
+        pitchEnv *= pitchDecay;
         ampEnv *= envDecay;
-        subEnv *= 0.9987f;
-        clickEnv *= 0.988f;
+        subEnv *= subDecay;
+        clickEnv *= clickDecay;
         
         if (ampEnv < 0.001f) {
             triggered = false;
@@ -70,7 +73,6 @@ public:
     }
     
 private:
-    static constexpr float HP_CUTOFF = 0.25f;
 
     float pitchEnv = ZERO;
     float ampEnv = ZERO;
@@ -80,6 +82,12 @@ private:
     float subPhase = ZERO;
     float hpNoiseState = ZERO;
     float sampleRate = 44100.0f;
+    clonotribe::Decay pitchDecay{0.9988f};
+    clonotribe::Decay ampDecay{0.9983f};
+    clonotribe::Decay subDecay{0.9987f};
+    clonotribe::Decay clickDecay{0.988f};
+    clonotribe::OnePole hpCutoff{0.25f};
+    float ampDecayJitter = 0.0001f;
     bool triggered = false;
 };
 }
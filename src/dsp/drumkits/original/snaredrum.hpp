@@ -1,6 +1,7 @@
 #pragma once
 #include "../../fastmath.hpp"
 #include "../../noise.hpp"
+#include "../../rate_coefficient.hpp"
 #include "../base/base.hpp"
 
 namespace drumkits {
@@ -24,6 +25,7 @@ public:
     
     void setSampleRate(float newSampleRate) override {
         sampleRate = newSampleRate;
+        clonotribe::rescale(sampleRate, toneDecay, buzzDecay, noiseDecay, ampDecay, bodyCutoff, cutoff1, cutoff2, hpCutoff);
     }
     
     [[nodiscard]] float process(float trig, float accent, clonotribe::NoiseGenerator& noise) override {
@@ -48,25 +50,25 @@ public:
         float tone2 = clonotribe::FastMath::fastSin(tonePhase2) * toneEnv * 0.6f;
         
         float toneSum = tone1 + tone2;
-        bodyFilter += (toneSum - bodyFilter) * 0.7f;
+        bodyFilter += (toneSum - bodyFilter) * bodyCutoff;
         
         float rawNoise = noise.process();
         
-        noiseFilter1 += (rawNoise - noiseFilter1) * CUTOFF_1;
-        noiseFilter2 += (noiseFilter1 - noiseFilter2) * CUTOFF_2;
+        noiseFilter1 += (rawNoise - noiseFilter1) * cutoff1;
+        noiseFilter2 += (noiseFilter1 - noiseFilter2) * cutoff2;
         float buzzNoise = (noiseFilter1 - noiseFilter2) * buzzEnv;
         
-        hpState += (buzzNoise - hpState) * HP_CUTOFF;
+        hpState += (buzzNoise - hpState) * hpCutoff;
         buzzNoise -= hpState;
 
         float bodyTone = bodyFilter * 0.45f;
         float snareNoise = buzzNoise * 0.75f;
         float output = bodyTone + snareNoise;
 
-        toneEnv *= 0.9935f;
-        buzzEnv *= 0.985f;
-        noiseEnv *= 0.988f;
-        ampEnv *= 0.990f;
+        toneEnv *= toneDecay;
+        buzzEnv *= buzzDecay;
+        noiseEnv *= noiseDecay;
+        ampEnv *= ampDecay;
         
         if (ampEnv < 0.001f && buzzEnv < 0.001f) {
             triggered = false;
@@ -79,9 +81,6 @@ public:
     }
     
 private:
-    static constexpr float HP_CUTOFF = 0.05f;
-    static constexpr float CUTOFF_1 = 0.28f;
-    static constexpr float CUTOFF_2 = 0.18f;
     static constexpr float FREQ1 = 210.0f;
     static constexpr float FREQ2 = 330.0f;
 
@@ -96,6 +95,14 @@ private:
     float bodyFilter = ZERO;
     float hpState = ZERO;
     float sampleRate = 44100.0f;
+    clonotribe::Decay toneDecay{0.9935f};
+    clonotribe::Decay buzzDecay{0.985f};
+    clonotribe::Decay noiseDecay{0.988f};
+    clonotribe::Decay ampDecay{0.990f};
+    clonotribe::OnePole bodyCutoff{0.7f};
+    clonotribe::OnePole cutoff1{0.28f};
+    clonotribe::OnePole cutoff2{0.18f};
+    clonotribe::OnePole hpCutoff{0.05f};
     bool triggered = false;
 };
 }
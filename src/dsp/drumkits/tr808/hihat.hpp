@@ -1,6 +1,7 @@
 #pragma once
 #include "../../fastmath.hpp"
 #include "../../noise.hpp"
+#include "../../rate_coefficient.hpp"
 #include "../base/base.hpp"
 
 namespace drumkits {
@@ -26,6 +27,7 @@ public:
     
     void setSampleRate(float newSampleRate) override {
         sampleRate = newSampleRate;
+        clonotribe::rescale(sampleRate, envDecay, hpCutoff, bp1Cutoff, bp2Cutoff);
     }
     
     [[nodiscard]] float process(float trig, float accent, clonotribe::NoiseGenerator& noise) override {
@@ -51,20 +53,20 @@ public:
         osc1Phase = phases[0]; osc2Phase = phases[1]; osc3Phase = phases[2];
         osc4Phase = phases[3]; osc5Phase = phases[4]; osc6Phase = phases[5];
         
-        bandpass1State1 += (squareSum - bandpass1State1) * BP1_CUTOFF;
-        bandpass1State2 += (bandpass1State1 - bandpass1State2) * BP1_CUTOFF;
+        bandpass1State1 += (squareSum - bandpass1State1) * bp1Cutoff;
+        bandpass1State2 += (bandpass1State1 - bandpass1State2) * bp1Cutoff;
         float bp1Out = bandpass1State1 - bandpass1State2;
         
-        bandpass2State1 += (bp1Out - bandpass2State1) * BP2_CUTOFF;
-        bandpass2State2 += (bandpass2State1 - bandpass2State2) * BP2_CUTOFF;
+        bandpass2State1 += (bp1Out - bandpass2State1) * bp2Cutoff;
+        bandpass2State2 += (bandpass2State1 - bandpass2State2) * bp2Cutoff;
         float bp2Out = bandpass2State1 - bandpass2State2;
         
-        highpassState += (bp2Out - highpassState) * HP_CUTOFF;
+        highpassState += (bp2Out - highpassState) * hpCutoff;
         float filteredSignal = bp2Out - highpassState;        
         float noiseComponent = noise.process() * 0.12f * env;
         float output = (filteredSignal + noiseComponent) * env;
         
-        env *= 0.9905f;
+        env *= envDecay;
         
         if (env < 0.001f) {
             triggered = false;
@@ -76,9 +78,6 @@ public:
     
 private:
     static constexpr float FREQUENCIES[6] = {418.0f, 539.0f, 707.0f, 869.0f, 1131.0f, 1319.0f};
-    static constexpr float HP_CUTOFF = 0.07f;
-    static constexpr float BP1_CUTOFF = 0.23f;
-    static constexpr float BP2_CUTOFF = 0.34f;
 
     float env = ZERO;
     float osc1Phase = ZERO;
@@ -93,6 +92,10 @@ private:
     float bandpass2State2 = ZERO;
     float highpassState = ZERO;
     float sampleRate = 44100.0f;
+    clonotribe::Decay envDecay{0.9905f};
+    clonotribe::OnePole hpCutoff{0.07f};
+    clonotribe::OnePole bp1Cutoff{0.23f};
+    clonotribe::OnePole bp2Cutoff{0.34f};
     bool triggered = false;
 };
 }
@@ -1,6 +1,7 @@
 #pragma once
 #include "../../fastmath.hpp"
 #include "../../noise.hpp"
+#include "../../rate_coefficient.hpp"
 #include "../base/base.hpp"
 
 namespace drumkits {
@@ -20,6 +21,7 @@ public:
     
     void setSampleRate(float newSampleRate) override {
         sampleRate = newSampleRate;
+        clonotribe::rescale(sampleRate, pitchDecay, ampDecay, clickDecay, hpCutoff);
     }
     
     [[nodiscard]] float process(float trig, float accent, clonotribe::NoiseGenerator& noise) override {
@@ -46,14 +48,14 @@ public:
         float subSine = clonotribe::FastMath::fastSin(subPhase) * 0.6f;        
         float n = noise.process();
         
-        hpState += (n - hpState) * HP_CUTOFF;
+        hpState += (n - hpState) * hpCutoff;
         float hpNoise = n - hpState;
         float click = (clickEnv > 0.8f ? (clickEnv - 0.8f) * 5.0f : ZERO) + hpNoise * 0.08f * clickEnv;
         float output = (mainSine + subSine + click * 0.3f) * ampEnv * ampEnv;
         
-        pitchEnv *= 0.9992f;
-        ampEnv *= 0.9986f;
-        clickEnv *= 0.9915f;
+        pitchEnv *= pitchDecay;
+        ampEnv *= ampDecay;
+        clickEnv *= clickDecay;
         
         if (ampEnv < 0.001f) {
             triggered = false;
@@ -64,7 +66,6 @@ public:
     }
     
 private:
-    static constexpr float HP_CUTOFF = 0.25f;
 
     float pitchEnv = ZERO;
     float ampEnv = ZERO;
@@ -73,6 +74,10 @@ private:
     float subPhase = ZERO;
     float hpState = ZERO;
     float sampleRate = 44100.0f;
+    clonotribe::Decay pitchDecay{0.9992f};
+    clonotribe::Decay ampDecay{0.9986f};
+    clonotribe::Decay clickDecay{0.9915f};
+    clonotribe::OnePole hpCutoff{0.25f};
     bool triggered = false;
 };
 }
@@ -1,6 +1,7 @@
 #pragma once
 #include "../../fastmath.hpp"
 #include "../../noise.hpp"
+#include "../../rate_coefficient.hpp"
 #include "../base/base.hpp"
 
 namespace drumkits {
@@ -22,6 +23,7 @@ public:
     
     void setSampleRate(float newSampleRate) override {
         sampleRate = newSampleRate;
+        clonotribe::rescale(sampleRate, toneDecay, noiseDecay, ampDecay, cutoff, hpCutoff);
     }
     
     [[nodiscard]] float process(float trig, float accent, clonotribe::NoiseGenerator& noise) override {
@@ -55,9 +57,9 @@ public:
         float filteredNoise = (bandpassOut - highpassState) * noiseEnv;        
         float output = toneSum * 0.35f + filteredNoise * 0.85f;
 
-        toneEnv *= 0.993f;
-        noiseEnv *= 0.9855f;
-        ampEnv *= 0.9885f;
+        toneEnv *= toneDecay;
+        noiseEnv *= noiseDecay;
+        ampEnv *= ampDecay;
         
         if (ampEnv < 0.001f) {
             triggered = false;
@@ -69,8 +71,6 @@ public:
     }
     
 private:
-    const float cutoff = 0.17f;
-    const float hpCutoff = 0.06f;
     const float freq1 = 330.0f;
     const float freq2 = 180.0f;
 
@@ -83,6 +83,11 @@ private:
     float bandpassState2 = ZERO;
     float highpassState = ZERO;
     float sampleRate = 44100.0f;
+    clonotribe::Decay toneDecay{0.993f};
+    clonotribe::Decay noiseDecay{0.9855f};
+    clonotribe::Decay ampDecay{0.9885f};
+    clonotribe::OnePole cutoff{0.17f};
+    clonotribe::OnePole hpCutoff{0.06f};
     bool triggered = false;
 };
 }
@@ -6,6 +6,7 @@
 #include "noise.hpp"
 #include "ribbon.hpp"
 #include "sequencer/sequencer.hpp"
+#include "sequencer/drum_pattern.hpp"
 #include "vco.hpp"
 #include "distortion.hpp"
 
@@ -1,9 +1,13 @@
 #pragma once
 #include "../constants.hpp"
-#include <rack.hpp>
+#include <algorithm>
+#include <cmath>
 
 namespace clonotribe {
 
+// Analog-style ADSR: every segment is a one-pole approach to a target just beyond its end, so
+// a sample costs one multiply-add. The coefficients only change with the type, the times or
+// the sample rate.
 struct Envelope final {
     enum class Type {
         ATTACK,
@@ -21,33 +25,56 @@ struct Envelope final {
 
     Stage stage = Stage::OFF;
     float value = ZERO;
-    float attack = 0.1f;
-    float decay = 0.1f;
-    float sustain = 0.7f;
-    float releaseTime = HALF;
 
-    void setAttack(float a) noexcept { attack = std::clamp(a, 0.001f, 10.0f); }
-    void setDecay(float d) noexcept { decay = std::clamp(d, 0.001f, 10.0f); }
-    void setSustain(float s) noexcept { sustain = std::clamp(s, ZERO, ONE); }
-    void setRelease(float r) noexcept { releaseTime = std::clamp(r, 0.001f, 10.0f); }
+    Envelope() noexcept { updateCoefficients(); }
+
+    void setSampleRate(float sampleRate) noexcept {
+        this->sampleRate = (sampleRate > 100.0f) ? sampleRate : 44100.0f;
+        updateCoefficients();
+    }
+
+    // Loads the segment times of the mode. GATE bypasses the envelope, so it keeps ATTACK's.
+    void setType(Type type) noexcept {
+        if (type == this->type) return;
+        this->type = type;
+        if (type == Type::DECAY) {
+            attack = 0.001f;
+            decay = HALF;
+            sustain = ZERO;
+            releaseTime = 0.001f;
+        } else {
+            attack = 0.1f;
+            decay = 0.1f;
+            sustain = ONE;
+            releaseTime = 0.1f;
+        }
+        updateCoefficients();
+    }
+
+    void setAttack(float a) noexcept { attack = std::clamp(a, 0.001f, 10.0f); updateCoefficients(); }
+    void setDecay(float d) noexcept { decay = std::clamp(d, 0.001f, 10.0f); updateCoefficients(); }
+    void setSustain(float s) noexcept { sustain = std::clamp(s, ZERO, ONE); updateCoefficients(); }
+    void setRelease(float r) noexcept { releaseTime = std::clamp(r, 0.001f, 10.0f); updateCoefficients(); }
     void trigger() noexcept { stage = Stage::ATTACK; }
     void gateOff() noexcept {
         if (stage != Stage::OFF) {
             stage = Stage::RELEASE;
         }
     }
-    
-    [[nodiscard]] float process(float sampleTime) noexcept {
+
+    [[nodiscard]] Type getType() const noexcept { return type; }
+
+    [[nodiscard]] float process() noexcept {
         switch (stage) {
             case Stage::ATTACK:
-                value += sampleTime / attack;
+                value = attackSegment.base + value * attackSegment.coefficient;
                 if (value >= ONE) {
                     value = ONE;
                     stage = Stage::DECAY;
                 }
                 break;
             case Stage::DECAY:
-                value -= sampleTime / decay;
+                value = decaySegment.base + value * decaySegment.coefficient;
                 if (value <= sustain) {
                     value = sustain;
                     stage = Stage::SUSTAIN;
@@ -57,7 +84,7 @@ struct Envelope final {
                 value = sustain;
                 break;
             case Stage::RELEASE:
-                value -= sampleTime / releaseTime;
+                value = releaseSegment.base + value * releaseSegment.coefficient;
                 if (value <= ZERO) {
                     value = ZERO;
                     stage = Stage::OFF;
@@ -69,5 +96,52 @@ struct Envelope final {
         }
         return value;
     }
+
+    // Renders `frames` consecutive samples, e.g. one per oversampled voice sample. Once the
+    // envelope holds (sustain or off) the rest of the block is a fill.
+    void process(float* out, int frames) noexcept {
+        for (int i = 0; i < frames; ++i) {
+            if (stage == Stage::SUSTAIN || stage == Stage::OFF) {
+                value = (stage == Stage::OFF) ? ZERO : sustain;
+                std::fill(out + i, out + frames, value);
+                return;
+            }
+            out[i] = process();
+        }
+    }
+
+private:
+    // How far past its end a segment aims: the attack overshoots like a charging capacitor,
+    // decay and release land at -40 dB of their span when their time is up.
+    static constexpr float ATTACK_OVERSHOOT = 0.3f;
+    static constexpr float DECAY_UNDERSHOOT = 0.01f;
+
+    struct Segment {
+        float base = ZERO;
+        float coefficient = ZERO;
+    };
+
+    Type type = Type::ATTACK;
+    float sampleRate = 44100.0f;
+    float attack = 0.1f;
+    float decay = 0.1f;
+    float sustain = ONE;
+    float releaseTime = 0.1f;
+    Segment attackSegment;
+    Segment decaySegment;
+    Segment releaseSegment;
+
+    // value = base + value * coefficient approaches `target`, which lies `overshoot` spans past
+    // the end, and so covers the span in `seconds`.
+    [[nodiscard]] Segment segment(float seconds, float target, float overshoot) const noexcept {
+        const float coefficient = std::exp(-std::log((ONE + overshoot) / overshoot) / (seconds * sampleRate));
+        return {target * (ONE - coefficient), coefficient};
+    }
+
+    void updateCoefficients() noexcept {
+        attackSegment = segment(attack, ONE + ATTACK_OVERSHOOT, ATTACK_OVERSHOOT);
+        decaySegment = segment(decay, sustain - DECAY_UNDERSHOOT * (ONE - sustain), DECAY_UNDERSHOOT);
+        releaseSegment = segment(releaseTime, -DECAY_UNDERSHOOT, DECAY_UNDERSHOOT);
+    }
 };
-}
\ No newline at end of file
+}
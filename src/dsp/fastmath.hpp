@@ -1,13 +1,66 @@
 #pragma once
 #include "../constants.hpp"
+#include "simd.hpp"
+#include <algorithm>
+#include <bit>
 #include <cmath>
+#include <cstdint>
 
 namespace clonotribe {
 
+// Per-type primitives behind the FastMath templates, so one formula serves float, float_4 and float_8.
+namespace vector_ops {
+inline float floor(float x) noexcept { return std::floor(x); }
+inline float abs(float x) noexcept { return std::abs(x); }
+inline float copySign(float magnitude, float sign) noexcept { return std::copysign(magnitude, sign); }
+inline float min(float a, float b) noexcept { return std::min(a, b); }
+inline float max(float a, float b) noexcept { return std::max(a, b); }
+inline float clamp(float x, float lo, float hi) noexcept { return std::clamp(x, lo, hi); }
+// Branch-free choice; the mask comes from a comparison (bool for float, lane mask for vectors).
+inline float select(bool mask, float a, float b) noexcept { return mask ? a : b; }
+// 2^n for integer-valued n in [-126, 127].
+inline float pow2(float n) noexcept { return std::bit_cast<float>((static_cast<int32_t>(n) + 127) << 23); }
+
+inline float_4 floor(float_4 x) noexcept {
+    __m128 truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(x.v));
+    return _mm_sub_ps(truncated, _mm_and_ps(_mm_cmpgt_ps(truncated, x.v), _mm_set1_ps(1.0f)));
+}
+inline float_4 abs(float_4 x) noexcept { return _mm_andnot_ps(_mm_set1_ps(-0.0f), x.v); }
+inline float_4 copySign(float_4 magnitude, float_4 sign) noexcept {
+    const __m128 bit = _mm_set1_ps(-0.0f);
+    return _mm_or_ps(_mm_andnot_ps(bit, magnitude.v), _mm_and_ps(bit, sign.v));
+}
+inline float_4 min(float_4 a, float_4 b) noexcept { return _mm_min_ps(a.v, b.v); }
+inline float_4 max(float_4 a, float_4 b) noexcept { return _mm_max_ps(a.v, b.v); }
+inline float_4 clamp(float_4 x, float_4 lo, float_4 hi) noexcept { return min(max(x, lo), hi); }
+inline float_4 select(float_4 mask, float_4 a, float_4 b) noexcept {
+    return _mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v));
+}
+inline float_4 pow2(float_4 n) noexcept {
+    return _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(_mm_cvttps_epi32(n.v), _mm_set1_epi32(127)), 23));
+}
+
+#if defined(__AVX2__)
+inline float_8 floor(float_8 x) noexcept { return _mm256_floor_ps(x.v); }
+inline float_8 abs(float_8 x) noexcept { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), x.v); }
+inline float_8 copySign(float_8 magnitude, float_8 sign) noexcept {
+    const __m256 bit = _mm256_set1_ps(-0.0f);
+    return _mm256_or_ps(_mm256_andnot_ps(bit, magnitude.v), _mm256_and_ps(bit, sign.v));
+}
+inline float_8 min(float_8 a, float_8 b) noexcept { return _mm256_min_ps(a.v, b.v); }
+inline float_8 max(float_8 a, float_8 b) noexcept { return _mm256_max_ps(a.v, b.v); }
+inline float_8 pow2(float_8 n) noexcept {
+    return _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_add_epi32(_mm256_cvttps_epi32(n.v), _mm256_set1_epi32(127)), 23));
+}
+#endif
+}
+
 struct FastMath final {
     static constexpr float PI = 3.14159265358979323846f;
     static constexpr float TWO_PI = TWO * PI;
     static constexpr float INV_PI = ONE / PI;
+    static constexpr float INV_TWO_PI = ONE / TWO_PI;
+    static constexpr float LOG2_E = 1.44269504088896341f;
 
     constexpr FastMath() noexcept = default;
     FastMath(const FastMath&) noexcept = default;
@@ -34,6 +87,14 @@ struct FastMath final {
         return x * (27.0f + x2) / (27.0f + 9.0f * x2);
     }
 
+    // fastTanh() for float_4 lanes, with the saturation as selects instead of branches.
+    template<typename T>
+    [[nodiscard]] static T fastTanh(T x) noexcept {
+        const T x2 = x * x;
+        const T rational = x * (27.0f + x2) / (27.0f + 9.0f * x2);
+        return vector_ops::select(x > 2.5f, T(ONE), vector_ops::select(x < -2.5f, T(-ONE), rational));
+    }
+
     [[nodiscard]] static inline float normalizePhase(float phase) noexcept {
         if (phase >= TWO_PI) {
             return phase - TWO_PI;
@@ -51,5 +112,59 @@ struct FastMath final {
     [[nodiscard]] static inline float fastInverse(float x) noexcept {
         return ONE / x;
     }
+
+    // Templated variants for float, float_4 and (AVX2 builds) float_8. Unlike the scalar
+    // helpers above they hold their accuracy over the whole range, for poly and block paths.
+
+    // Phase in cycles wrapped to [0, 1).
+    template<typename T>
+    [[nodiscard]] static T wrapPhase(T phase) noexcept {
+        return phase - vector_ops::floor(phase);
+    }
+
+    // Absolute error about 1e-6 for |x| < 10; the float range reduction adds more for larger |x|.
+    template<typename T>
+    [[nodiscard]] static T sin(T x) noexcept {
+        T cycles = x * T(INV_TWO_PI);
+        cycles = cycles - vector_ops::floor(cycles + T(HALF));
+        // Fold [-0.5, 0.5] cycles onto [-0.25, 0.25], where the odd polynomial converges.
+        T folded = T(0.25f) - vector_ops::abs(vector_ops::abs(cycles) - T(0.25f));
+        T y = vector_ops::copySign(folded, cycles) * T(TWO_PI);
+        T y2 = y * y;
+        T p = T(-ONE / 39916800.0f);
+        p = T(ONE / 362880.0f) + y2 * p;
+        p = T(-ONE / 5040.0f) + y2 * p;
+        p = T(ONE / 120.0f) + y2 * p;
+        p = T(-ONE / 6.0f) + y2 * p;
+        return y * (T(ONE) + y2 * p);
+    }
+
+    template<typename T>
+    [[nodiscard]] static T cos(T x) noexcept {
+        return sin(x + T(PI * HALF));
+    }
+
+    // Relative error below 5e-6.
+    template<typename T>
+    [[nodiscard]] static T exp2(T x) noexcept {
+        x = vector_ops::min(vector_ops::max(x, T(-126.0f)), T(126.0f));
+        T whole = vector_ops::floor(x + T(HALF));
+        T f = x - whole;
+        T p = T(ONE) + f * (T(0.693147181f) + f * (T(0.240226507f) + f * (T(0.0555041087f) + f * (T(0.00961812911f) + f * T(0.00133335581f)))));
+        return p * vector_ops::pow2(whole);
+    }
+
+    template<typename T>
+    [[nodiscard]] static T exp(T x) noexcept {
+        return exp2(x * T(LOG2_E));
+    }
+
+    // Absolute error below 3e-6; saturates exactly to +-1.
+    template<typename T>
+    [[nodiscard]] static T tanh(T x) noexcept {
+        x = vector_ops::min(vector_ops::max(x, T(-9.0f)), T(9.0f));
+        T e = exp2(x * T(TWO * LOG2_E));
+        return (e - T(ONE)) / (e + T(ONE));
+    }
 };
 }
\ No newline at end of file
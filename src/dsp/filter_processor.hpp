@@ -1,4 +1,10 @@
 #pragma once
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include "shared_table.hpp"
+#include "vcf/filter_coefficients.hpp"
 #include "vcf/ms20.hpp"
 #include "vcf/ladder.hpp"
 #include "vcf/moog.hpp"
@@ -8,104 +14,117 @@ namespace clonotribe {
 
 class FilterProcessor final {
 public:
-    explicit FilterProcessor(MS20Filter& ms20) noexcept : ms20(&ms20), ladder(nullptr), moog(nullptr), filterType(FilterType::MS20) {}
-    explicit FilterProcessor(LadderFilter& ladder) noexcept : ms20(nullptr), ladder(&ladder), moog(nullptr), filterType(FilterType::LADDER) {}
-    explicit FilterProcessor(MoogFilter& moog) noexcept : ms20(nullptr), ladder(nullptr), moog(&moog), filterType(FilterType::MOOG) {}
+    explicit FilterProcessor(MS20Filter& ms20) noexcept : ms20(&ms20), ladder(nullptr), moog(nullptr), filterType(FilterType::MS20), requestedType(FilterType::MS20) {}
+    explicit FilterProcessor(LadderFilter& ladder) noexcept : ms20(nullptr), ladder(&ladder), moog(nullptr), filterType(FilterType::LADDER), requestedType(FilterType::LADDER) {}
+    explicit FilterProcessor(MoogFilter& moog) noexcept : ms20(nullptr), ladder(nullptr), moog(&moog), filterType(FilterType::MOOG), requestedType(FilterType::MOOG) {}
 
+    // Switches immediately, without a fade.
     void setFilterType(FilterType type, MS20Filter* ms20Ptr, LadderFilter* ladderPtr, MoogFilter* moogPtr) noexcept {
         filterType = type;
-        ms20 = ms20Ptr;
-        ladder = ladderPtr;
-        moog = moogPtr;
+        requestedType.store(type);
+        fadeRemaining = 0;
+        setPointers(ms20Ptr, ladderPtr, moogPtr);
     }
 
     [[nodiscard]] float process(float input, float cutoff, float resonance) noexcept {
+        update(cutoff, resonance);
+        return processSample(input);
+    }
+
+    // Hands the parameters to the active filter, and to the outgoing one while a type change
+    // fades. Runs once per host sample, ahead of one processSample() call per oversampled
+    // sample. Callers ramp the values beforehand (see ParameterRamp).
+    void update(float cutoff, float resonance) noexcept {
+        if(!active) {
+            return;
+        }
+        lastCutoff = cutoff;
+        lastResonance = resonance;
+        adoptPreparedTable();
+        applyRequestedSolver();
+        startPendingSwap();
+        auto apply = [&](auto& filter) {
+            filter.setCutoff(cutoff);
+            filter.setResonance(resonance);
+        };
+        withFilter(filterType, apply);
+        if (fadeRemaining > 0) withFilter(previousType, apply);
+    }
+
+    [[nodiscard]] float processSample(float input) noexcept {
         if(!active) {
             return ZERO;
         }
-        if (std::abs(input) < 1e-30f) {
-            input = ZERO;
+        float output = ZERO;
+        withFilter(filterType, [&](auto& filter) { output = filter.process(input); });
+        if (fadeRemaining > 0) {
+            float outgoing = ZERO;
+            withFilter(previousType, [&](auto& filter) { outgoing = filter.process(input); });
+            float weight = static_cast<float>(fadeRemaining--) / static_cast<float>(fadeLength);
+            output += (outgoing - output) * weight;
         }
-        
-        float smoothedCutoff = cutoff;
-        float smoothedResonance = resonance;
-        
-        float cutoffDelta = std::abs(cutoff - lastCutoff);
-        float resonanceDelta = std::abs(resonance - lastResonance);
-        
-        if (cutoffDelta > CUTOFF_THRESHOLD) {
-            float smoothFactor = std::clamp(0.05f + cutoffDelta * 0.1f, 0.05f, 0.3f);
-            smoothedCutoff = lastCutoff + (cutoff - lastCutoff) * smoothFactor;
-            lastCutoff = smoothedCutoff;
-        } else {
-            lastCutoff = cutoff;
+        lastOutput = output;
+        return output;
+    }
+
+    // Statically dispatched variant for kernels specialised on the filter type. Falls back to
+    // the dynamic path while fading, and until the kernel is reselected after a type change.
+    template<FilterType F>
+    [[nodiscard]] float processSample(float input) noexcept {
+        if (!active) {
+            return ZERO;
         }
-        
-        if (resonanceDelta > RESONANCE_THRESHOLD) {
-            float smoothFactor = std::clamp(0.1f + resonanceDelta * 0.2f, 0.1f, 0.4f);
-            smoothedResonance = lastResonance + (resonance - lastResonance) * smoothFactor;
-            lastResonance = smoothedResonance;
-        } else {
-            lastResonance = resonance;
+        if (F != filterType || fadeRemaining > 0) {
+            return processSample(input);
         }
-        
-        switch (filterType) {
-            case FilterType::MS20:
-                if (ms20) {
-                    ms20->setCutoff(smoothedCutoff);
-                    ms20->setResonance(smoothedResonance);
-                    float output = ms20->process(input);
-                    if (std::abs(output) < 1e-30f) output = ZERO;
-                    return output;
-                }
-                break;
-            case FilterType::LADDER:
-                if (ladder) {
-                    ladder->setCutoff(smoothedCutoff);
-                    ladder->setResonance(smoothedResonance);
-                    float output = ladder->process(input);
-                    if (std::abs(output) < 1e-30f) output = ZERO;
-                    return output;
-                }
-                break;
-            case FilterType::MOOG:
-                if (moog) {
-                    moog->setCutoff(smoothedCutoff);
-                    moog->setResonance(smoothedResonance);
-                    float output = moog->process(input);
-                    if (std::abs(output) < 1e-30f) output = ZERO;
-                    return output;
-                }
-                break;
-            default:
-                break;
+        float output;
+        if constexpr (F == FilterType::MS20) {
+            output = ms20 ? ms20->process(input) : ZERO;
+        } else if constexpr (F == FilterType::LADDER) {
+            output = ladder ? ladder->process(input) : ZERO;
+        } else {
+            output = moog ? moog->process(input) : ZERO;
         }
-        return ZERO;
+        lastOutput = output;
+        return output;
+    }
+
+    // Builds or acquires the shared coefficient table for this rate. Not for the audio thread:
+    // call it from wherever the rate or quality is chosen, ahead of setSampleRate().
+    void prepareSampleRate(float sampleRate) {
+        sampleRate = std::max(FilterCoefficientTable::MIN_SAMPLE_RATE, sampleRate);
+        collectTables();
+        if (!preparedTables.empty() && preparedTables.back()->table->sampleRate == sampleRate) return;
+        preparedTables.push_back(std::make_unique<PreparedTable>(PreparedTable{CoefficientTable(sampleRate), ++preparedSequence}));
+        pendingTable.store(preparedTables.back().get(), std::memory_order_release);
+    }
+
+    // Releases the tables the audio thread has moved on from. Same thread as prepareSampleRate().
+    void collectTables() {
+        uint32_t adopted = adoptedSequence.load(std::memory_order_acquire);
+        preparedTables.erase(std::remove_if(preparedTables.begin(), preparedTables.end(), [adopted](const std::unique_ptr<PreparedTable>& p) {
+            return static_cast<int32_t>(p->sequence - adopted) < 0;
+        }), preparedTables.end());
+    }
+
+    // Audio thread. Switches every filter to the prepared table for this rate; until one is
+    // prepared the filters compute their coefficients directly.
+    void setSampleRate(float sampleRate) noexcept {
+        sampleRate = std::max(FilterCoefficientTable::MIN_SAMPLE_RATE, sampleRate);
+        this->sampleRate = sampleRate;
+        if (ms20) ms20->setSampleRate(sampleRate);
+        if (ladder) ladder->setSampleRate(sampleRate);
+        if (moog) moog->setSampleRate(sampleRate);
+        adoptPreparedTable();
+        fadeLength = std::max(1, static_cast<int>(FADE_SECONDS * sampleRate));
+        fadeRemaining = std::min(fadeRemaining, fadeLength);
     }
 
     void forceUpdate(float cutoff, float resonance) noexcept {
-        switch (filterType) {
-            case FilterType::MS20:
-                if (ms20) {
-                    ms20->setCutoff(cutoff);
-                    ms20->setResonance(resonance);
-                }
-                break;
-            case FilterType::LADDER:
-                if (ladder) {
-                    ladder->setCutoff(cutoff);
-                    ladder->setResonance(resonance);
-                }
-                break;
-            case FilterType::MOOG:
-                if (moog) {
-                    moog->setCutoff(cutoff);
-                    moog->setResonance(resonance);
-                }
-                break;
-            default:
-                break;
-        }
+        withFilter(filterType, [&](auto& filter) {
+            filter.setCutoff(cutoff);
+            filter.setResonance(resonance);
+        });
         lastCutoff = cutoff;
         lastResonance = resonance;
     }
@@ -119,26 +138,130 @@ public:
         ms20 = vcfPtr;
         ladder = ladderPtr;
         moog = moogPtr;
+        shareCoefficients();
+        applySolver(solver);
     }
 
-    void setType(FilterType type) noexcept { filterType = type; }
+    // Safe to call from the UI thread: the next update() crossfades from the current model to
+    // the new one over FADE_SECONDS, running both only for that long.
+    void setType(FilterType type) noexcept { requestedType.store(type); }
+
+    // When on, the incoming model's state is set from the outgoing model's last output, so the
+    // fade starts from a matching level instead of silence.
+    void setStateSeeding(bool seeding) noexcept { stateSeeding = seeding; }
+
+    // The Moog model has a single solver; the setting applies to MS20 and Ladder. Safe to call
+    // from the UI thread: the next update() switches the filters.
+    void setSolver(FilterSolver solver) noexcept { requestedSolver.store(solver, std::memory_order_relaxed); }
+
+    // The requested solver, which the filters run from the next update() on.
+    [[nodiscard]] FilterSolver getSolver() const noexcept { return requestedSolver.load(std::memory_order_relaxed); }
 
+    // The model currently running (the incoming one during a fade).
     FilterType getType() const noexcept { return filterType; }
 
+    [[nodiscard]] bool isFading() const noexcept { return fadeRemaining > 0; }
+
     void setActive(bool active) noexcept {
         this->active = active;
     }
 
 private:
-    static constexpr float CUTOFF_THRESHOLD = MIN;
-    static constexpr float RESONANCE_THRESHOLD = MIN;
+    static constexpr float FADE_SECONDS = 0.005f;
 
     MS20Filter* ms20;
     LadderFilter* ladder;
     MoogFilter* moog;
     FilterType filterType;
+    std::atomic<FilterType> requestedType;
+    FilterType previousType = FilterType::MS20;
+    int fadeLength = static_cast<int>(FADE_SECONDS * 44100.f);
+    int fadeRemaining = 0;
+    bool stateSeeding = true;
+    float lastOutput = ZERO;
+    FilterSolver solver = FilterSolver::EULER;
+    std::atomic<FilterSolver> requestedSolver{FilterSolver::EULER};
     float lastCutoff = -ONE;
     float lastResonance = -ONE;
     bool active;
+
+    // Tables are built by prepareSampleRate() and handed over through pendingTable. A table is
+    // only released once the audio thread has adopted a later one, and never on the audio thread.
+    using CoefficientTable = SharedTable<FilterCoefficientTable, float>;
+    struct PreparedTable {
+        CoefficientTable table;
+        uint32_t sequence = 0;
+    };
+    std::vector<std::unique_ptr<PreparedTable>> preparedTables;
+    uint32_t preparedSequence = 0;
+    std::atomic<const PreparedTable*> pendingTable{nullptr};
+    std::atomic<uint32_t> adoptedSequence{0};
+    const FilterCoefficientTable* coefficients = nullptr;
+    float sampleRate = 44100.f;
+
+    template<typename Fn>
+    void withFilter(FilterType type, Fn&& fn) noexcept {
+        switch (type) {
+            case FilterType::MS20:
+                if (ms20) fn(*ms20);
+                break;
+            case FilterType::LADDER:
+                if (ladder) fn(*ladder);
+                break;
+            case FilterType::MOOG:
+                if (moog) fn(*moog);
+                break;
+            default:
+                break;
+        }
+    }
+
+    // Waits for a running fade to finish, so at most two models ever run.
+    void startPendingSwap() noexcept {
+        FilterType type = requestedType.load(std::memory_order_relaxed);
+        if (type == filterType || fadeRemaining > 0) return;
+        previousType = filterType;
+        filterType = type;
+        withFilter(type, [&](auto& filter) {
+            if (stateSeeding) {
+                filter.seed(lastOutput);
+            } else {
+                filter.reset();
+            }
+            filter.setCutoff(lastCutoff);
+            filter.setResonance(lastResonance);
+        });
+        fadeRemaining = fadeLength;
+    }
+
+    void applyRequestedSolver() noexcept {
+        FilterSolver requested = requestedSolver.load(std::memory_order_relaxed);
+        if (requested != solver) applySolver(requested);
+    }
+
+    void applySolver(FilterSolver solver) noexcept {
+        this->solver = solver;
+        if (ms20) ms20->setSolver(solver);
+        if (ladder) ladder->setSolver(solver);
+    }
+
+    // A table prepared for another rate stays pending until the rate matches or it is replaced.
+    // The filters let go of the previous table before it is acknowledged.
+    void adoptPreparedTable() noexcept {
+        const PreparedTable* prepared = pendingTable.load(std::memory_order_acquire);
+        if (!prepared || prepared->table->sampleRate != sampleRate) return;
+        uint32_t sequence = prepared->sequence;
+        coefficients = prepared->table.get();
+        shareCoefficients();
+        pendingTable.compare_exchange_strong(prepared, nullptr, std::memory_order_acq_rel);
+        adoptedSequence.store(sequence, std::memory_order_release);
+    }
+
+    void shareCoefficients() noexcept {
+        if (!coefficients) return;
+        if (ms20) ms20->setCoefficientTable(coefficients);
+        if (ladder) ladder->setCoefficientTable(coefficients);
+        if (moog) moog->setCoefficientTable(coefficients);
+    }
 };
 }
@@ -0,0 +1,60 @@
+#include "kernels.hpp"
+
+namespace clonotribe {
+
+namespace {
+float halfband(const float* window, const float* coefficients, int taps) noexcept {
+    // Four partial sums break the add dependency chain.
+    float sum[4] = {};
+    int k = 0;
+    for (; k + 4 <= taps; k += 4) {
+        for (int j = 0; j < 4; ++j) {
+            sum[j] += coefficients[k + j] * (window[taps - 1 - k - j] + window[taps + k + j]);
+        }
+    }
+    for (; k < taps; ++k) {
+        sum[0] += coefficients[k] * (window[taps - 1 - k] + window[taps + k]);
+    }
+    return (sum[0] + sum[1]) + (sum[2] + sum[3]);
+}
+}
+
+namespace kernels {
+const Kernels GENERIC = {halfband};
+}
+
+const Kernels* Kernels::current = &kernels::GENERIC;
+
+Kernels::Isa Kernels::detect() noexcept {
+    return isSupported(Isa::AVX2) ? Isa::AVX2 : Isa::GENERIC;
+}
+
+bool Kernels::isSupported(Isa isa) noexcept {
+    switch (isa) {
+        case Isa::AVX2:
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+            return kernels::AVX2 && __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#else
+            return false;
+#endif
+        case Isa::GENERIC:
+        default:
+            return true;
+    }
+}
+
+bool Kernels::select(Isa isa) noexcept {
+    if (!isSupported(isa)) return false;
+    current = isa == Isa::AVX2 ? kernels::AVX2 : &kernels::GENERIC;
+    return true;
+}
+
+Kernels::Isa Kernels::selected() noexcept {
+    return current == &kernels::GENERIC ? Isa::GENERIC : Isa::AVX2;
+}
+
+const char* Kernels::name(Isa isa) noexcept {
+    static const char* names[] = {"generic", "avx2"};
+    return names[static_cast<int>(isa)];
+}
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+namespace clonotribe {
+
+// Hot DSP loops compiled once per instruction set. The plugin starts on the generic table and
+// init() switches to the best one the CPU supports; select() can force any supported table.
+struct Kernels final {
+    enum class Isa { GENERIC, AVX2 };
+
+    // Symmetric FIR over a window of 2 * taps samples:
+    // sum of coefficients[k] * (window[taps - 1 - k] + window[taps + k]).
+    float (*halfband)(const float* window, const float* coefficients, int taps) noexcept;
+
+    [[nodiscard]] static const Kernels& active() noexcept { return *current; }
+
+    [[nodiscard]] static Isa detect() noexcept;
+    [[nodiscard]] static bool isSupported(Isa isa) noexcept;
+    // Returns false, and keeps the current table, when the CPU or the build lacks the ISA.
+    static bool select(Isa isa) noexcept;
+    [[nodiscard]] static Isa selected() noexcept;
+    [[nodiscard]] static const char* name(Isa isa) noexcept;
+
+private:
+    static const Kernels* current;
+};
+
+namespace kernels {
+extern const Kernels GENERIC;
+// nullptr when the build has no AVX2 variant (non-x86 targets).
+extern const Kernels* const AVX2;
+}
+}
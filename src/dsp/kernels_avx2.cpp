@@ -0,0 +1,49 @@
+// Built with -mavx2 -mfma (see Makefile). Only intrinsics and file-local code live here:
+// an inline function from a shared header would be emitted with AVX2 encodings and the
+// linker could hand that copy to the generic path.
+#include "kernels.hpp"
+#if defined(__AVX2__) && defined(__FMA__)
+#include <immintrin.h>
+#endif
+
+namespace clonotribe {
+
+#if defined(__AVX2__) && defined(__FMA__)
+namespace {
+float halfband(const float* window, const float* coefficients, int taps) noexcept {
+    const __m256i reverse8 = _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+    __m256 sum8 = _mm256_setzero_ps();
+    int k = 0;
+    for (; k + 8 <= taps; k += 8) {
+        __m256 backward = _mm256_permutevar8x32_ps(_mm256_loadu_ps(window + taps - 8 - k), reverse8);
+        __m256 forward = _mm256_loadu_ps(window + taps + k);
+        sum8 = _mm256_fmadd_ps(_mm256_loadu_ps(coefficients + k), _mm256_add_ps(backward, forward), sum8);
+    }
+    __m128 sum4 = _mm_add_ps(_mm256_castps256_ps128(sum8), _mm256_extractf128_ps(sum8, 1));
+    for (; k + 4 <= taps; k += 4) {
+        __m128 backward = _mm_loadu_ps(window + taps - 4 - k);
+        backward = _mm_shuffle_ps(backward, backward, _MM_SHUFFLE(0, 1, 2, 3));
+        __m128 forward = _mm_loadu_ps(window + taps + k);
+        sum4 = _mm_fmadd_ps(_mm_loadu_ps(coefficients + k), _mm_add_ps(backward, forward), sum4);
+    }
+    sum4 = _mm_add_ps(sum4, _mm_movehl_ps(sum4, sum4));
+    sum4 = _mm_add_ss(sum4, _mm_shuffle_ps(sum4, sum4, 1));
+    float sum = _mm_cvtss_f32(sum4);
+    for (; k < taps; ++k) {
+        sum += coefficients[k] * (window[taps - 1 - k] + window[taps + k]);
+    }
+    return sum;
+}
+
+const Kernels TABLE = {halfband};
+}
+
+namespace kernels {
+const Kernels* const AVX2 = &TABLE;
+}
+#else
+namespace kernels {
+const Kernels* const AVX2 = nullptr;
+}
+#endif
+}
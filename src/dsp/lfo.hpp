@@ -1,8 +1,10 @@
 #pragma once
-#include <rack.hpp>
 #include <array>
 #include <algorithm>
+#include <cmath>
+#include <cstdint>
 #include "fastmath.hpp"
+#include "noise.hpp"
 
 namespace clonotribe {
 
@@ -11,8 +13,12 @@ class LFO final {
     static constexpr float SLOW_MAX_HZ = 18.0f;
     static constexpr float FAST_MIN_HZ = 1.0f;
     static constexpr float FAST_MAX_HZ = 5000.0f;
+    static constexpr uint32_t DEFAULT_SEED = 0x9E3779B9u;
 
 public:
+    // Slow and one-shot LFOs are evaluated once per block and interpolated in between.
+    static constexpr int CONTROL_INTERVAL = 32;
+
     enum class Waveform {
         SQUARE = 0,
         TRIANGLE = 1,
@@ -32,7 +38,7 @@ public:
         VCO = 2
     };
 
-    constexpr LFO() noexcept = default;
+    LFO() noexcept { setSeed(0); }
     LFO(const LFO&) noexcept = default;
     LFO& operator=(const LFO&) noexcept = default;
     LFO(LFO&&) noexcept = default;
@@ -41,13 +47,23 @@ public:
 
     [[nodiscard]] float process(Mode mode, float rate, bool externalCV, bool rising, Waveform waveform, float intensity, float sampleTime) {
         update(mode, rate, externalCV, rising);
-        return processInternal(sampleTime, waveform) * intensity;
+        if (mode == Mode::FAST) {
+            controlValue = processInternal(sampleTime, waveform);
+            controlRemaining = 0;
+            return controlValue * intensity;
+        }
+        return processControlRate(sampleTime, waveform) * intensity;
+    }
+
+    // Sample-and-hold draws from this instance's own generator, so renders repeat exactly.
+    void setSeed(uint32_t seed) noexcept {
+        random.setSeed((seed ^ DEFAULT_SEED) | 1u);
     }
 
     void setSampleAndHold(bool sh) noexcept {
         sampleAndHold = sh;
         if (sh) {
-            sampleHoldValue = (rack::random::uniform() - HALF) * TWO;
+            sampleHoldValue = random.generateWhiteNoise();
         }
     }
 
@@ -55,6 +71,7 @@ public:
         if (oneShot) {
             phase = ZERO;
             triggered = true;
+            controlRemaining = 0;
         }
     }
 
@@ -87,8 +104,27 @@ private:
     bool triggered = false;
     bool active = true;
     bool sampleAndHold = false;
+    NoiseGenerator random{};
+    Mode cachedMode = Mode::SLOW;
+    float cachedRate = -ONE;
+    bool cachedRateCV = false;
+    float controlValue = ZERO;
+    float controlStep = ZERO;
+    int controlRemaining = 0;
 
     void update(Mode mode, float rate, bool rateCVConnected, bool gateRising) {
+        if (mode != cachedMode || rate != cachedRate || rateCVConnected != cachedRateCV) {
+            cachedMode = mode;
+            cachedRate = rate;
+            cachedRateCV = rateCVConnected;
+            updateFrequency(mode, rate, rateCVConnected);
+        }
+        if (gateRising && (mode == Mode::FAST || mode == Mode::ONE_SHOT)) {
+            trigger();
+        }
+    }
+
+    void updateFrequency(Mode mode, float rate, bool rateCVConnected) noexcept {
         if (rateCVConnected) {
             freq = rate;
         } else {
@@ -113,9 +149,19 @@ private:
             }
             freq = minHz * std::pow(maxHz / minHz, std::clamp(rate, ZERO, ONE));
         }
-        if (gateRising && (mode == Mode::FAST || mode == Mode::ONE_SHOT)) {
-            trigger();
+    }
+
+    // Evaluates the waveform at the end of each block and ramps towards it, so edges and
+    // S&H steps are spread over one block (under 1 ms at 44.1 kHz).
+    [[nodiscard]] float processControlRate(float sampleTime, Waveform waveform) noexcept {
+        if (controlRemaining == 0) {
+            float target = processInternal(sampleTime * static_cast<float>(CONTROL_INTERVAL), waveform);
+            controlStep = (target - controlValue) * (ONE / static_cast<float>(CONTROL_INTERVAL));
+            controlRemaining = CONTROL_INTERVAL;
         }
+        --controlRemaining;
+        controlValue += controlStep;
+        return controlValue;
     }
 
     [[nodiscard]] float processInternal(float sampleTime, Waveform waveform = Waveform::SQUARE) noexcept {
@@ -139,7 +185,7 @@ private:
 
         if (sampleAndHold) {
             if (phase < lastPhase) {
-                sampleHoldValue = (rack::random::uniform() - HALF) * TWO;
+                sampleHoldValue = random.generateWhiteNoise();
             }
             output = sampleHoldValue;
         } else {
@@ -159,7 +205,7 @@ private:
                     break;
                 case Waveform::SAMPLE_HOLD:
                     if (phase < lastPhase) {
-                        sampleHoldValue = (rack::random::uniform() - HALF) * TWO;
+                        sampleHoldValue = random.generateWhiteNoise();
                     }
                     output = sampleHoldValue;
                     break;
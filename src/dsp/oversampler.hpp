@@ -0,0 +1,171 @@
+#pragma once
+#include <array>
+#include <cmath>
+#include "fastmath.hpp"
+#include "kernels.hpp"
+
+namespace clonotribe {
+
+// Kaiser-windowed halfband lowpass. Apart from the 0.5 centre tap only odd taps are non-zero,
+// so both directions run as two-branch polyphase filters over TAPS symmetric coefficients.
+// coefficients()[k] is twice the tap at +-(2k + 1); they sum to 0.5.
+template<int TAPS>
+struct Halfband final {
+    static const std::array<float, TAPS>& coefficients() {
+        static const std::array<float, TAPS> c = design();
+        return c;
+    }
+
+    // Sum of c[k] * (w[TAPS - 1 - k] + w[TAPS + k]) over a window of 2 * TAPS samples.
+    [[nodiscard]] static float convolve(const float* window) noexcept {
+        return Kernels::active().halfband(window, coefficients().data(), TAPS);
+    }
+
+private:
+    static constexpr double BETA = TAPS >= 8 ? 8.0 : 6.0;
+
+    static double besselI0(double x) {
+        double sum = 1.0;
+        double term = 1.0;
+        for (int k = 1; k < 32; ++k) {
+            term *= (x * 0.5 / k) * (x * 0.5 / k);
+            sum += term;
+        }
+        return sum;
+    }
+
+    static std::array<float, TAPS> design() {
+        std::array<double, TAPS> taps{};
+        const double half = 2.0 * TAPS;
+        double sum = 0.0;
+        for (int k = 0; k < TAPS; ++k) {
+            const double n = 2.0 * k + 1.0;
+            const double ratio = n / half;
+            const double window = besselI0(BETA * std::sqrt(1.0 - ratio * ratio)) / besselI0(BETA);
+            taps[static_cast<size_t>(k)] = std::sin(M_PI * n * 0.5) / (M_PI * n) * window;
+            sum += taps[static_cast<size_t>(k)];
+        }
+        std::array<float, TAPS> c{};
+        for (int k = 0; k < TAPS; ++k) {
+            c[static_cast<size_t>(k)] = static_cast<float>(taps[static_cast<size_t>(k)] * 0.5 / sum);
+        }
+        return c;
+    }
+};
+
+// Sample history that always exposes the last SIZE values as one contiguous window, oldest first.
+template<int SIZE>
+class History final {
+public:
+    void push(float x) noexcept {
+        index = index + 1 == SIZE ? 0 : index + 1;
+        buffer[static_cast<size_t>(index)] = x;
+        buffer[static_cast<size_t>(index + SIZE)] = x;
+    }
+
+    [[nodiscard]] const float* window() const noexcept { return buffer.data() + index + 1; }
+
+    void reset() noexcept {
+        buffer.fill(ZERO);
+        index = 0;
+    }
+
+private:
+    std::array<float, 2 * SIZE> buffer{};
+    int index = 0;
+};
+
+// 2x interpolator: one input sample in, two output samples out, TAPS input samples late.
+template<int TAPS>
+class Upsampler2x final {
+public:
+    [[nodiscard]] std::array<float, 2> process(float x) noexcept {
+        history.push(x);
+        const float* window = history.window();
+        return {window[TAPS - 1], Halfband<TAPS>::convolve(window)};
+    }
+
+    void reset() noexcept { history.reset(); }
+
+private:
+    History<2 * TAPS> history;
+};
+
+// 2x decimator: the even sample is only delayed, the odd branch carries the filter.
+template<int TAPS>
+class Decimator2x final {
+public:
+    [[nodiscard]] float process(float even, float odd) noexcept {
+        evens.push(even);
+        odds.push(odd);
+        return HALF * evens.window()[0] + HALF * Halfband<TAPS>::convolve(odds.window());
+    }
+
+    void reset() noexcept {
+        evens.reset();
+        odds.reset();
+    }
+
+private:
+    History<TAPS> evens;
+    History<2 * TAPS> odds;
+};
+
+// Runs a kernel at 1x, 2x or 4x the host rate. 4x cascades a short halfband stage inside the
+// 2x one: by then the signal is already band-limited, so the transition band can be wide.
+class Oversampler final {
+public:
+    static constexpr int MAX_FACTOR = 4;
+
+    // Eco runs at the host rate, Normal at 2x, HQ at 4x.
+    enum class Quality { ECO, NORMAL, HQ };
+
+    [[nodiscard]] static constexpr int factorFor(Quality quality) noexcept {
+        return 1 << static_cast<int>(quality);
+    }
+
+    void setFactor(int factor) noexcept {
+        this->factor = factor >= 4 ? 4 : (factor >= 2 ? 2 : 1);
+        reset();
+    }
+
+    [[nodiscard]] int getFactor() const noexcept { return factor; }
+
+    void reset() noexcept {
+        outerUp.reset();
+        outerDown.reset();
+        innerUp.reset();
+        innerDown.reset();
+    }
+
+    // The kernel is stateful, so it is always called in sample order.
+    template<typename Kernel>
+    [[nodiscard]] float process(float input, Kernel&& kernel) {
+        if (factor == 1) return kernel(input);
+        auto outer = outerUp.process(input);
+        if (factor == 2) {
+            float even = kernel(outer[0]);
+            float odd = kernel(outer[1]);
+            return outerDown.process(even, odd);
+        }
+        std::array<float, 2> decimated{};
+        for (size_t i = 0; i < 2; ++i) {
+            auto inner = innerUp.process(outer[i]);
+            float even = kernel(inner[0]);
+            float odd = kernel(inner[1]);
+            decimated[i] = innerDown.process(even, odd);
+        }
+        return outerDown.process(decimated[0], decimated[1]);
+    }
+
+private:
+    static constexpr int OUTER_TAPS = 12;
+    static constexpr int INNER_TAPS = 4;
+
+    int factor = 1;
+    Upsampler2x<OUTER_TAPS> outerUp;
+    Decimator2x<OUTER_TAPS> outerDown;
+    Upsampler2x<INNER_TAPS> innerUp;
+    Decimator2x<INNER_TAPS> innerDown;
+};
+}
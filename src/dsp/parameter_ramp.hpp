@@ -0,0 +1,83 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include "../constants.hpp"
+
+namespace clonotribe {
+
+// Linear de-zippering for a control value. The value moves in sub-blocks of one ramp length:
+// at the start of each sub-block it takes the latest target and steps towards it in equal
+// increments, arriving exactly at the end. A value that keeps moving is followed with at most
+// two ramp lengths of lag, and the slope never depends on how often the target is set. The
+// length is given in milliseconds, so the response is the same at every sample rate.
+class ParameterRamp final {
+public:
+    ParameterRamp() noexcept { updateLength(); }
+    explicit ParameterRamp(float timeMs) noexcept : timeMs(timeMs) { updateLength(); }
+
+    void setSampleRate(float sampleRate) noexcept {
+        this->sampleRate = (sampleRate > 100.0f) ? sampleRate : 44100.0f;
+        updateLength();
+    }
+
+    void setTime(float timeMs) noexcept {
+        this->timeMs = std::max(ZERO, timeMs);
+        updateLength();
+    }
+
+    void setTarget(float target) noexcept { this->target = target; }
+
+    // Advances one sample and returns the ramped value.
+    [[nodiscard]] float process() noexcept {
+        if (remaining == 0) {
+            if (value == target) {
+                return value;
+            }
+            startBlock();
+        }
+        value = (--remaining == 0) ? blockTarget : value + increment;
+        return value;
+    }
+
+    [[nodiscard]] float process(float target) noexcept {
+        setTarget(target);
+        return process();
+    }
+
+    // Jumps to the value without ramping.
+    void reset(float value) noexcept {
+        this->value = target = blockTarget = value;
+        increment = ZERO;
+        remaining = 0;
+    }
+
+    [[nodiscard]] float getValue() const noexcept { return value; }
+    [[nodiscard]] float getTarget() const noexcept { return target; }
+    [[nodiscard]] bool isRamping() const noexcept { return remaining > 0 || value != target; }
+    [[nodiscard]] int getLength() const noexcept { return length; }
+
+private:
+    float sampleRate = 44100.0f;
+    float timeMs = 5.0f;
+    int length = 1;
+    int remaining = 0;
+    float value = ZERO;
+    float target = ZERO;
+    float blockTarget = ZERO;
+    float increment = ZERO;
+
+    void startBlock() noexcept {
+        blockTarget = target;
+        increment = (blockTarget - value) / static_cast<float>(length);
+        remaining = length;
+    }
+
+    void updateLength() noexcept {
+        length = std::max(1, static_cast<int>(std::lround(timeMs * 0.001f * sampleRate)));
+        if (remaining > length) {
+            remaining = length;
+            increment = (blockTarget - value) / static_cast<float>(length);
+        }
+    }
+};
+}
@@ -46,6 +46,8 @@ auto Clonotribe::readParameters() -> std::tuple<float, float, float, float, floa
         paramCache.ribbonMode = static_cast<Ribbon::Mode>(params[PARAM_RIBBON_RANGE_SWITCH].getValue());
         paramCache.vcoWaveform = static_cast<VCO::Waveform>(params[PARAM_VCO_WAVEFORM_SWITCH].getValue());
         paramCache.resetUpdateCounter();
+        envelope.setType(paramCache.envelopeType);
+        selectVoiceKernel(paramCache.vcoWaveform, filterProcessor.getType(), paramCache.envelopeType, paramCache.lfoTarget);
     }
 
     return {paramCache.cutoff, paramCache.lfoIntensity, paramCache.lfoRate, paramCache.noiseLevel, 
@@ -171,7 +173,7 @@ bool Clonotribe::isStepActiveInCurrentMode(int step) {
             return (idx >= 0 && idx < sequencer.getStepCount()) && !sequencer.isStepSkipped(idx);
         } else {
             int drumIndex = static_cast<int>(sequencer.getSelectedDrumPart()) - 1;
-            return (drumIndex >= 0 && drumIndex < 3) ? drumPatterns[drumIndex][step] : false;
+            return drumPattern.isSet(drumIndex, step);
         }
     } else {
         if (sequencer.getSelectedDrumPart() == DrumPart::SYNTH) {
@@ -179,7 +181,7 @@ bool Clonotribe::isStepActiveInCurrentMode(int step) {
             return (idx >= 0 && idx < sequencer.getStepCount()) && !sequencer.isStepMuted(idx);
         } else {
             int drumIndex = static_cast<int>(sequencer.getSelectedDrumPart()) - 1;
-            return (drumIndex >= 0 && drumIndex < 3) ? drumPatterns[drumIndex][step] : false;
+            return drumPattern.isSet(drumIndex, step);
         }
     }
 }
@@ -191,14 +193,12 @@ void Clonotribe::clearAllSequences() {
 
 void Clonotribe::clearSynthSequence() {
     sequencer.clearSequence();
+    markPatternEdited();
 }
 
 void Clonotribe::clearDrumSequence() {
-    for (int d = 0; d < 3; d++) {
-        for (int s = 0; s < 8; s++) {
-            drumPatterns[d][s] = false;
-        }
-    }
+    drumPattern.clear();
+    markPatternEdited();
 }
 
 void Clonotribe::enableAllActiveSteps() {
@@ -206,10 +206,7 @@ void Clonotribe::enableAllActiveSteps() {
         sequencer.enableAllSteps();
     } else {
         int drumIndex = static_cast<int>(sequencer.getSelectedDrumPart()) - 1;
-        if (drumIndex >= 0 && drumIndex < 3) {
-            for (int s = 0; s < 8; s++) {
-                drumPatterns[drumIndex][s] = true;
-            }
-        }
+        drumPattern.fillLane(drumIndex, sequencer.getStepCount());
     }
+    markPatternEdited();
 }
\ No newline at end of file
@@ -0,0 +1,37 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include "../constants.hpp"
+
+namespace clonotribe {
+
+// A per-sample constant tuned by ear at REFERENCE_RATE, rescaled so it keeps its time constant
+// (DECAY: x *= c) or its cutoff (ONE_POLE: y += (x - y) * c) at the running rate. Components
+// hand all of theirs to rescale() from setSampleRate(), so process() only reads floats.
+template<bool ONE_POLE>
+class RateCoefficient final {
+public:
+    static constexpr float REFERENCE_RATE = 44100.0f;
+
+    constexpr explicit RateCoefficient(float reference) noexcept : reference(reference), value(reference) {}
+
+    void setSampleRate(float sampleRate) noexcept {
+        const float ratio = REFERENCE_RATE / std::max(ONE, sampleRate);
+        value = ONE_POLE ? ONE - std::pow(ONE - reference, ratio) : std::pow(reference, ratio);
+    }
+
+    [[nodiscard]] constexpr operator float() const noexcept { return value; }
+
+private:
+    float reference;
+    float value;
+};
+
+using Decay = RateCoefficient<false>;
+using OnePole = RateCoefficient<true>;
+
+template<typename... Coefficients>
+void rescale(float sampleRate, Coefficients&... coefficients) noexcept {
+    (coefficients.setSampleRate(sampleRate), ...);
+}
+}
@@ -0,0 +1,99 @@
+#pragma once
+#include <array>
+#include <cstdint>
+
+namespace clonotribe {
+
+// Drum lanes packed as one bit per step, so a step query or a whole-lane edit is a single mask operation.
+struct DrumPattern final {
+    static constexpr int LANES = 3;
+    static constexpr int MAX_STEPS = 64;
+    static constexpr int LEGACY_STEPS = 8;
+
+    std::array<uint64_t, LANES> hits{};
+    std::array<uint64_t, LANES> accents{};
+
+    [[nodiscard]] static constexpr uint64_t stepBit(int step) noexcept {
+        return (step >= 0 && step < MAX_STEPS) ? (uint64_t{1} << step) : 0;
+    }
+
+    [[nodiscard]] static constexpr uint64_t firstSteps(int count) noexcept {
+        if (count <= 0) return 0;
+        return count >= MAX_STEPS ? ~uint64_t{0} : (uint64_t{1} << count) - 1;
+    }
+
+    [[nodiscard]] static constexpr bool validLane(int lane) noexcept {
+        return lane >= 0 && lane < LANES;
+    }
+
+    [[nodiscard]] bool isSet(int lane, int step) const noexcept {
+        return validLane(lane) && (hits[static_cast<size_t>(lane)] & stepBit(step)) != 0;
+    }
+
+    void set(int lane, int step, bool value) noexcept {
+        if (!validLane(lane)) return;
+        uint64_t bit = stepBit(step);
+        auto& mask = hits[static_cast<size_t>(lane)];
+        mask = value ? (mask | bit) : (mask & ~bit);
+        if (!value) accents[static_cast<size_t>(lane)] &= ~bit;
+    }
+
+    void toggle(int lane, int step) noexcept {
+        set(lane, step, !isSet(lane, step));
+    }
+
+    [[nodiscard]] bool isAccent(int lane, int step) const noexcept {
+        return validLane(lane) && (accents[static_cast<size_t>(lane)] & stepBit(step)) != 0;
+    }
+
+    void setAccent(int lane, int step, bool value) noexcept {
+        if (!validLane(lane)) return;
+        uint64_t bit = stepBit(step);
+        auto& mask = accents[static_cast<size_t>(lane)];
+        mask = value ? (mask | bit) : (mask & ~bit);
+    }
+
+    // Accent only makes sense on a hit, so toggling it on also sets the hit.
+    void toggleAccent(int lane, int step) noexcept {
+        bool accent = !isAccent(lane, step);
+        if (accent) set(lane, step, true);
+        setAccent(lane, step, accent);
+    }
+
+    // Bit d of the result is set when lane d fires on this step.
+    [[nodiscard]] uint32_t lanesAt(int step) const noexcept {
+        uint64_t bit = stepBit(step);
+        return ((hits[0] & bit) ? 1u : 0u) | ((hits[1] & bit) ? 2u : 0u) | ((hits[2] & bit) ? 4u : 0u);
+    }
+
+    [[nodiscard]] uint32_t accentsAt(int step) const noexcept {
+        uint64_t bit = stepBit(step);
+        return ((accents[0] & bit) ? 1u : 0u) | ((accents[1] & bit) ? 2u : 0u) | ((accents[2] & bit) ? 4u : 0u);
+    }
+
+    void fillLane(int lane, int stepCount) noexcept {
+        if (validLane(lane)) hits[static_cast<size_t>(lane)] |= firstSteps(stepCount);
+    }
+
+    void clear() noexcept {
+        hits.fill(0);
+        accents.fill(0);
+    }
+
+    // Older patches stored 8 booleans per lane and no accents. In 16-step mode those eight
+    // steps played on the even steps.
+    [[nodiscard]] static DrumPattern fromLegacy(const std::array<std::array<bool, LEGACY_STEPS>, LANES>& lanes, bool sixteenStepMode) noexcept {
+        DrumPattern pattern;
+        for (int lane = 0; lane < LANES; ++lane) {
+            for (int step = 0; step < LEGACY_STEPS; ++step) {
+                if (lanes[static_cast<size_t>(lane)][static_cast<size_t>(step)]) {
+                    pattern.set(lane, sixteenStepMode ? step * 2 : step, true);
+                }
+            }
+        }
+        return pattern;
+    }
+
+    [[nodiscard]] bool operator==(const DrumPattern&) const noexcept = default;
+};
+}
@@ -0,0 +1,540 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "../../constants.hpp"
+#include "sequencer.hpp"
+#include "drum_pattern.hpp"
+
+namespace clonotribe {
+
+// One synth step lane plus the three drum lanes, as stored in a Standard MIDI File.
+struct MidiPattern {
+    std::array<Sequencer::Step, Sequencer::MAX_STEPS> steps{};
+    int stepCount = Sequencer::DEFAULT_STEPS;
+    DrumPattern drums;
+};
+
+struct MidiFormat final {
+    static constexpr uint16_t PPQ = 96;
+    static constexpr uint32_t TICKS_PER_STEP = PPQ / 4;
+    static constexpr int SYNTH_CHANNEL = 0;
+    static constexpr int DRUM_CHANNEL = 9;
+    static constexpr int BASE_NOTE = 60;
+    static constexpr int DRUM_NOTES[3] = {36, 38, 42};
+    static constexpr uint8_t VELOCITY_NORMAL = 100;
+    static constexpr uint8_t VELOCITY_ACCENT = 127;
+    static constexpr uint8_t ACCENT_THRESHOLD = 115;
+    // Skip flags have no MIDI equivalent; they travel in a sequencer-specific meta event
+    // (0x7F) under the non-commercial manufacturer id.
+    static constexpr uint8_t META_SEQUENCER = 0x7F;
+    static constexpr uint8_t SEQUENCER_ID = 0x7D;
+    static constexpr uint8_t SKIP_RECORD = 'S';
+
+    [[nodiscard]] static int pitchToNote(float pitch) noexcept {
+        return std::clamp(BASE_NOTE + static_cast<int>(std::lround(pitch * 12.0f)), 0, 127);
+    }
+
+    [[nodiscard]] static float noteToPitch(int note) noexcept {
+        return static_cast<float>(note - BASE_NOTE) / 12.0f;
+    }
+};
+
+// Writes a type 1 file: a tempo track followed by one track per pattern.
+class MidiFileWriter final {
+public:
+    [[nodiscard]] bool write(std::ostream& out, const std::vector<MidiPattern>& patterns, float bpm = 120.0f) const {
+        writeHeader(out, static_cast<uint16_t>(patterns.size() + 1));
+
+        std::string track;
+        appendTempoTrack(track, bpm);
+        writeTrack(out, track);
+
+        for (size_t i = 0; i < patterns.size(); ++i) {
+            track.clear();
+            appendPatternTrack(track, patterns[i], static_cast<int>(i));
+            writeTrack(out, track);
+        }
+        return static_cast<bool>(out);
+    }
+
+private:
+    struct NoteEvent {
+        uint32_t tick;
+        uint8_t status;
+        uint8_t note;
+        uint8_t velocity;
+    };
+
+    static void putU16(std::ostream& out, uint16_t v) {
+        out.put(static_cast<char>(v >> 8));
+        out.put(static_cast<char>(v & 0xFF));
+    }
+
+    static void putU32(std::ostream& out, uint32_t v) {
+        out.put(static_cast<char>(v >> 24));
+        out.put(static_cast<char>((v >> 16) & 0xFF));
+        out.put(static_cast<char>((v >> 8) & 0xFF));
+        out.put(static_cast<char>(v & 0xFF));
+    }
+
+    static void appendVarLen(std::string& track, uint32_t v) {
+        uint8_t bytes[4];
+        int count = 0;
+        do {
+            bytes[count++] = static_cast<uint8_t>(v & 0x7F);
+            v >>= 7;
+        } while (v > 0 && count < 4);
+        while (count > 1) {
+            track.push_back(static_cast<char>(bytes[--count] | 0x80));
+        }
+        track.push_back(static_cast<char>(bytes[0]));
+    }
+
+    static void appendMeta(std::string& track, uint32_t delta, uint8_t type, const std::string& data) {
+        appendVarLen(track, delta);
+        track.push_back(static_cast<char>(0xFF));
+        track.push_back(static_cast<char>(type));
+        appendVarLen(track, static_cast<uint32_t>(data.size()));
+        track += data;
+    }
+
+    static void writeHeader(std::ostream& out, uint16_t trackCount) {
+        out.write("MThd", 4);
+        putU32(out, 6);
+        putU16(out, 1);
+        putU16(out, trackCount);
+        putU16(out, MidiFormat::PPQ);
+    }
+
+    static void writeTrack(std::ostream& out, const std::string& track) {
+        out.write("MTrk", 4);
+        putU32(out, static_cast<uint32_t>(track.size()));
+        out.write(track.data(), static_cast<std::streamsize>(track.size()));
+    }
+
+    static void appendTempoTrack(std::string& track, float bpm) {
+        uint32_t usPerQuarter = static_cast<uint32_t>(60000000.0f / std::clamp(bpm, ONE, 1000.0f));
+        std::string tempo = {
+            static_cast<char>((usPerQuarter >> 16) & 0xFF),
+            static_cast<char>((usPerQuarter >> 8) & 0xFF),
+            static_cast<char>(usPerQuarter & 0xFF)
+        };
+        appendMeta(track, 0, 0x51, tempo);
+        appendMeta(track, 0, 0x2F, "");
+    }
+
+    static void appendPatternTrack(std::string& track, const MidiPattern& pattern, int index) {
+        constexpr uint32_t tps = MidiFormat::TICKS_PER_STEP;
+        int stepCount = std::clamp(pattern.stepCount, 1, Sequencer::MAX_STEPS);
+        std::vector<NoteEvent> events;
+        events.reserve(static_cast<size_t>(stepCount) * 2 * (1 + DrumPattern::LANES));
+
+        auto sounding = [&](int step) {
+            const auto& s = pattern.steps[static_cast<size_t>(step)];
+            return !s.skipped && !s.muted;
+        };
+
+        for (int i = 0; i < stepCount; ++i) {
+            if (!sounding(i)) continue;
+            const auto& step = pattern.steps[static_cast<size_t>(i)];
+            uint8_t note = static_cast<uint8_t>(MidiFormat::pitchToNote(step.pitch));
+            uint8_t velocity = step.accent ? MidiFormat::VELOCITY_ACCENT : MidiFormat::VELOCITY_NORMAL;
+            uint32_t on = static_cast<uint32_t>(i) * tps;
+            uint32_t length = std::max<uint32_t>(1, static_cast<uint32_t>(std::clamp(step.gateTime, 0.1f, ONE) * static_cast<float>(tps)));
+
+            // A glide into the next step is written as legato: this note is held past the next note-on.
+            int next = i + 1;
+            if (next < stepCount && sounding(next) && pattern.steps[static_cast<size_t>(next)].glide) {
+                length = tps + 1;
+            }
+            events.push_back({on, static_cast<uint8_t>(0x90 | MidiFormat::SYNTH_CHANNEL), note, velocity});
+            events.push_back({on + length, static_cast<uint8_t>(0x80 | MidiFormat::SYNTH_CHANNEL), note, 0});
+        }
+
+        for (int d = 0; d < DrumPattern::LANES; ++d) {
+            uint8_t note = static_cast<uint8_t>(MidiFormat::DRUM_NOTES[d]);
+            for (int step = 0; step < stepCount; ++step) {
+                if (!pattern.drums.isSet(d, step)) continue;
+                uint8_t velocity = pattern.drums.isAccent(d, step) ? MidiFormat::VELOCITY_ACCENT : MidiFormat::VELOCITY_NORMAL;
+                uint32_t on = static_cast<uint32_t>(step) * tps;
+                events.push_back({on, static_cast<uint8_t>(0x90 | MidiFormat::DRUM_CHANNEL), note, velocity});
+                events.push_back({on + tps / 2, static_cast<uint8_t>(0x80 | MidiFormat::DRUM_CHANNEL), note, 0});
+            }
+        }
+
+        // Note-offs sort before note-ons on the same tick so repeated notes do not cut each other.
+        std::stable_sort(events.begin(), events.end(), [](const NoteEvent& a, const NoteEvent& b) {
+            if (a.tick != b.tick) return a.tick < b.tick;
+            return (a.status & 0xF0) < (b.status & 0xF0);
+        });
+
+        appendMeta(track, 0, 0x03, "Pattern " + std::to_string(index + 1));
+        uint32_t skipMask = 0;
+        for (int i = 0; i < stepCount; ++i) {
+            if (pattern.steps[static_cast<size_t>(i)].skipped) skipMask |= 1u << i;
+        }
+        if (skipMask != 0) {
+            appendMeta(track, 0, MidiFormat::META_SEQUENCER, {
+                static_cast<char>(MidiFormat::SEQUENCER_ID),
+                static_cast<char>(MidiFormat::SKIP_RECORD),
+                static_cast<char>((skipMask >> 8) & 0xFF),
+                static_cast<char>(skipMask & 0xFF)
+            });
+        }
+        uint32_t lastTick = 0;
+        for (const auto& e : events) {
+            appendVarLen(track, e.tick - lastTick);
+            track.push_back(static_cast<char>(e.status));
+            track.push_back(static_cast<char>(e.note));
+            track.push_back(static_cast<char>(e.velocity));
+            lastTick = e.tick;
+        }
+        uint32_t endTick = std::max(lastTick, static_cast<uint32_t>(stepCount) * tps);
+        appendMeta(track, endTick - lastTick, 0x2F, "");
+    }
+};
+
+// Event-driven reader: chunks are parsed straight off the stream and handed to a handler,
+// so arbitrarily large files are processed without holding them in memory.
+//
+// Handler must provide (a handler returning false rejects the file):
+//   void onHeader(uint16_t format, uint16_t trackCount, uint16_t division);
+//   void onTrackStart(int track);
+//   bool onChannelEvent(uint64_t tick, uint8_t status, uint8_t data1, uint8_t data2);
+//   void onSequencerData(const uint8_t* data, size_t size);
+//   bool onTrackEnd(uint64_t endTick);
+class MidiFileReader final {
+public:
+    template <typename Handler>
+    [[nodiscard]] bool read(std::istream& in, Handler& handler) {
+        buf = in.rdbuf();
+        if (!buf) return false;
+
+        char id[4];
+        uint32_t headerLength = 0;
+        if (!readId(id) || std::string(id, 4) != "MThd" || !readU32(headerLength) || headerLength < 6) {
+            return false;
+        }
+        uint16_t trackCount = 0;
+        if (!readU16(format) || !readU16(trackCount) || !readU16(division)) {
+            return false;
+        }
+        if ((division & 0x8000) != 0 || division == 0) {
+            return false;
+        }
+        if (!skip(headerLength - 6)) return false;
+        handler.onHeader(format, trackCount, division);
+
+        int track = 0;
+        while (track < trackCount) {
+            uint32_t length = 0;
+            if (!readId(id) || !readU32(length)) {
+                return track > 0;
+            }
+            if (std::string(id, 4) != "MTrk") {
+                if (!skip(length)) return false;
+                continue;
+            }
+            handler.onTrackStart(track);
+            if (!readTrack(length, handler)) return false;
+            ++track;
+        }
+        return true;
+    }
+
+    [[nodiscard]] uint16_t getFormat() const noexcept { return format; }
+    [[nodiscard]] uint16_t getDivision() const noexcept { return division; }
+
+private:
+    static constexpr uint32_t MAX_SEQUENCER_DATA = 16;
+
+    std::streambuf* buf = nullptr;
+    uint16_t format = 0;
+    uint16_t division = MidiFormat::PPQ;
+
+    [[nodiscard]] bool readByte(uint8_t& b) {
+        int c = buf->sbumpc();
+        if (c == std::char_traits<char>::eof()) return false;
+        b = static_cast<uint8_t>(c);
+        return true;
+    }
+
+    [[nodiscard]] bool readId(char* id) {
+        return buf->sgetn(id, 4) == 4;
+    }
+
+    [[nodiscard]] bool readU16(uint16_t& v) {
+        uint8_t hi, lo;
+        if (!readByte(hi) || !readByte(lo)) return false;
+        v = static_cast<uint16_t>((hi << 8) | lo);
+        return true;
+    }
+
+    [[nodiscard]] bool readU32(uint32_t& v) {
+        v = 0;
+        for (int i = 0; i < 4; ++i) {
+            uint8_t b;
+            if (!readByte(b)) return false;
+            v = (v << 8) | b;
+        }
+        return true;
+    }
+
+    [[nodiscard]] bool skip(uint32_t count) {
+        for (uint32_t i = 0; i < count; ++i) {
+            if (buf->sbumpc() == std::char_traits<char>::eof()) return false;
+        }
+        return true;
+    }
+
+    template <typename Handler>
+    [[nodiscard]] bool readTrack(uint32_t length, Handler& handler) {
+        uint32_t remaining = length;
+        // Deltas are at most 28 bits and a track holds fewer than 2^32 of them.
+        uint64_t tick = 0;
+        uint8_t runningStatus = 0;
+
+        auto next = [&](uint8_t& b) {
+            if (remaining == 0 || !readByte(b)) return false;
+            --remaining;
+            return true;
+        };
+        auto varLen = [&](uint32_t& v) {
+            v = 0;
+            for (int i = 0; i < 4; ++i) {
+                uint8_t b;
+                if (!next(b)) return false;
+                v = (v << 7) | (b & 0x7F);
+                if ((b & 0x80) == 0) return true;
+            }
+            return false;
+        };
+
+        while (remaining > 0) {
+            uint32_t delta = 0;
+            uint8_t status = 0;
+            if (!varLen(delta) || !next(status)) return false;
+            tick += delta;
+
+            if (status == 0xFF) {
+                uint8_t type = 0;
+                uint32_t size = 0;
+                if (!next(type) || !varLen(size) || size > remaining) return false;
+                if (type == MidiFormat::META_SEQUENCER && size <= MAX_SEQUENCER_DATA) {
+                    uint8_t data[MAX_SEQUENCER_DATA];
+                    for (uint32_t i = 0; i < size; ++i) {
+                        if (!next(data[i])) return false;
+                    }
+                    handler.onSequencerData(data, size);
+                    continue;
+                }
+                if (!skip(size)) return false;
+                remaining -= size;
+                if (type == 0x2F) {
+                    return handler.onTrackEnd(tick) && skip(remaining);
+                }
+                continue;
+            }
+            if (status == 0xF0 || status == 0xF7) {
+                uint32_t size = 0;
+                if (!varLen(size) || size > remaining) return false;
+                if (!skip(size)) return false;
+                remaining -= size;
+                continue;
+            }
+
+            uint8_t data1 = 0;
+            if (status & 0x80) {
+                runningStatus = status;
+                if (!next(data1)) return false;
+            } else {
+                if (runningStatus == 0) return false;
+                data1 = status;
+                status = runningStatus;
+            }
+            uint8_t data2 = 0;
+            uint8_t kind = status & 0xF0;
+            if (kind != 0xC0 && kind != 0xD0) {
+                if (!next(data2)) return false;
+            }
+            if (!handler.onChannelEvent(tick, status, data1, data2)) return false;
+        }
+        return handler.onTrackEnd(tick);
+    }
+};
+
+// Turns reader events into patterns. Each track starts a new pattern; tracks longer than
+// sixteen steps are split into consecutive sixteen-step patterns, so a bank can be stored
+// either as one track per pattern or as one long track. A file that would produce more than
+// MAX_PATTERNS patterns is rejected.
+class MidiPatternParser final {
+public:
+    static constexpr size_t MAX_PATTERNS = 1024;
+
+    explicit MidiPatternParser(std::vector<MidiPattern>& patterns) noexcept : patterns(patterns), firstPattern(patterns.size()) {}
+
+    void onHeader(uint16_t, uint16_t, uint16_t division) noexcept {
+        ticksPerStep = std::max<uint32_t>(1, division / 4u);
+    }
+
+    void onTrackStart(int) {
+        trackBase = patterns.size();
+        maxStep = -1;
+        lastSynthStep = -1;
+        skipMask = 0;
+        held.clear();
+    }
+
+    [[nodiscard]] bool onChannelEvent(uint64_t tick, uint8_t status, uint8_t data1, uint8_t data2) {
+        uint8_t kind = status & 0xF0;
+        int channel = status & 0x0F;
+        bool noteOn = kind == 0x90 && data2 > 0;
+        bool noteOff = kind == 0x80 || (kind == 0x90 && data2 == 0);
+        if (!noteOn && !noteOff) return true;
+
+        if (channel == MidiFormat::DRUM_CHANNEL) {
+            return !noteOn || addDrum(tick, data1, data2);
+        }
+        if (noteOn) return addSynthNote(tick, data1, data2);
+        releaseSynthNote(tick, data1);
+        return true;
+    }
+
+    void onSequencerData(const uint8_t* data, size_t size) {
+        if (size == 4 && data[0] == MidiFormat::SEQUENCER_ID && data[1] == MidiFormat::SKIP_RECORD) {
+            skipMask = static_cast<uint32_t>((data[2] << 8) | data[3]);
+        }
+    }
+
+    [[nodiscard]] bool onTrackEnd(uint64_t endTick) {
+        for (const auto& note : held) {
+            finishNote(note, endTick);
+        }
+        held.clear();
+        for (int i = Sequencer::MAX_STEPS - 1; i >= 0; --i) {
+            if (skipMask & (1u << i)) {
+                maxStep = std::max(maxStep, i);
+                break;
+            }
+        }
+        if (maxStep < 0) return true;
+        if (!ensurePatterns(1)) return false;
+        for (int i = 0; i < Sequencer::MAX_STEPS; ++i) {
+            if (skipMask & (1u << i)) patterns[trackBase].steps[static_cast<size_t>(i)].skipped = true;
+        }
+
+        uint64_t totalSteps = std::max(tickToStep(endTick), static_cast<uint64_t>(maxStep) + 1);
+        uint64_t count = (totalSteps + Sequencer::MAX_STEPS - 1) / Sequencer::MAX_STEPS;
+        if (count > MAX_PATTERNS || !ensurePatterns(static_cast<size_t>(count))) return false;
+        uint64_t lastSteps = totalSteps - (count - 1) * Sequencer::MAX_STEPS;
+        patterns[trackBase + count - 1].stepCount = (lastSteps <= Sequencer::DEFAULT_STEPS) ? Sequencer::DEFAULT_STEPS : Sequencer::MAX_STEPS;
+        return true;
+    }
+
+private:
+    struct HeldNote {
+        uint8_t note = 0;
+        uint64_t tick = 0;
+        size_t pattern = 0;
+        int step = 0;
+    };
+
+    std::vector<MidiPattern>& patterns;
+    size_t firstPattern = 0;
+    uint32_t ticksPerStep = MidiFormat::TICKS_PER_STEP;
+    size_t trackBase = 0;
+    int maxStep = -1;
+    int lastSynthStep = -1;
+    uint32_t skipMask = 0;
+    // Oldest first. A glide between equal pitches overlaps two notes of the same pitch, so a
+    // note-off releases the oldest note it matches.
+    std::vector<HeldNote> held;
+
+    [[nodiscard]] uint64_t tickToStep(uint64_t tick) const noexcept {
+        return (tick + ticksPerStep / 2) / ticksPerStep;
+    }
+
+    // Makes sure the current track owns at least count patterns. False past MAX_PATTERNS.
+    [[nodiscard]] bool ensurePatterns(size_t count) {
+        if (trackBase + count - firstPattern > MAX_PATTERNS) return false;
+        while (patterns.size() < trackBase + count) {
+            MidiPattern pattern;
+            pattern.stepCount = Sequencer::MAX_STEPS;
+            for (auto& step : pattern.steps) {
+                step.muted = true;
+                step.gate = 5.0f;
+                step.gateTime = 0.8f;
+            }
+            patterns.push_back(pattern);
+        }
+        return true;
+    }
+
+    // The step of this tick within the track, once the pattern holding it exists.
+    [[nodiscard]] bool placeStep(uint64_t tick, int& step) {
+        uint64_t wide = tickToStep(tick);
+        if (wide >= MAX_PATTERNS * Sequencer::MAX_STEPS) return false;
+        step = static_cast<int>(wide);
+        if (!ensurePatterns(static_cast<size_t>(step / Sequencer::MAX_STEPS) + 1)) return false;
+        maxStep = std::max(maxStep, step);
+        return true;
+    }
+
+    [[nodiscard]] bool addDrum(uint64_t tick, uint8_t note, uint8_t velocity) {
+        for (int d = 0; d < DrumPattern::LANES; ++d) {
+            if (MidiFormat::DRUM_NOTES[d] != note) continue;
+            int step = 0;
+            if (!placeStep(tick, step)) return false;
+            DrumPattern& drums = patterns[trackBase + static_cast<size_t>(step / Sequencer::MAX_STEPS)].drums;
+            drums.set(d, step % Sequencer::MAX_STEPS, true);
+            drums.setAccent(d, step % Sequencer::MAX_STEPS, velocity >= MidiFormat::ACCENT_THRESHOLD);
+        }
+        return true;
+    }
+
+    [[nodiscard]] bool addSynthNote(uint64_t tick, uint8_t note, uint8_t velocity) {
+        int step = 0;
+        if (!placeStep(tick, step)) return false;
+        size_t index = static_cast<size_t>(step / Sequencer::MAX_STEPS);
+        int local = step % Sequencer::MAX_STEPS;
+        auto& s = patterns[trackBase + index].steps[static_cast<size_t>(local)];
+        s.muted = false;
+        s.skipped = false;
+        s.pitch = MidiFormat::noteToPitch(note);
+        s.gate = 5.0f;
+        s.accent = velocity >= MidiFormat::ACCENT_THRESHOLD;
+        s.glide = !held.empty() && lastSynthStep >= 0 && lastSynthStep != step;
+        lastSynthStep = step;
+        held.push_back({note, tick, trackBase + index, local});
+        return true;
+    }
+
+    void releaseSynthNote(uint64_t tick, uint8_t note) {
+        auto it = std::find_if(held.begin(), held.end(), [note](const HeldNote& h) { return h.note == note; });
+        if (it == held.end()) return;
+        finishNote(*it, tick);
+        held.erase(it);
+    }
+
+    void finishNote(const HeldNote& h, uint64_t tick) {
+        float length = static_cast<float>(tick - h.tick) / static_cast<float>(ticksPerStep);
+        patterns[h.pattern].steps[static_cast<size_t>(h.step)].gateTime = std::clamp(length, 0.1f, ONE);
+    }
+};
+
+[[nodiscard]] inline bool readMidiPatterns(std::istream& in, std::vector<MidiPattern>& patterns) {
+    MidiFileReader reader;
+    MidiPatternParser parser(patterns);
+    return reader.read(in, parser);
+}
+
+[[nodiscard]] inline bool writeMidiPatterns(std::ostream& out, const std::vector<MidiPattern>& patterns, float bpm = 120.0f) {
+    return MidiFileWriter().write(out, patterns, bpm);
+}
+}
@@ -0,0 +1,233 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <vector>
+#include "sequencer.hpp"
+#include "drum_pattern.hpp"
+
+namespace clonotribe {
+
+// Everything undo/redo covers, as a plain value.
+struct PatternState final {
+    std::array<Sequencer::Step, Sequencer::MAX_STEPS> steps{};
+    DrumPattern drums;
+    bool sixteenStepMode = false;
+
+    bool operator==(const PatternState&) const noexcept = default;
+};
+
+// Immutable pattern version. Synth steps live in fixed-size blocks that are shared between
+// versions, so a version that changes one step only allocates the block holding that step.
+struct PatternSnapshot final {
+    static constexpr int BLOCK_SIZE = 4;
+    static constexpr int BLOCKS = Sequencer::MAX_STEPS / BLOCK_SIZE;
+    using StepBlock = std::array<Sequencer::Step, BLOCK_SIZE>;
+
+    std::array<std::shared_ptr<const StepBlock>, BLOCKS> blocks{};
+    DrumPattern drums;
+    bool sixteenStepMode = false;
+
+    [[nodiscard]] const Sequencer::Step& step(int i) const noexcept {
+        return (*blocks[static_cast<size_t>(i / BLOCK_SIZE)])[static_cast<size_t>(i % BLOCK_SIZE)];
+    }
+
+    void copyTo(std::array<Sequencer::Step, Sequencer::MAX_STEPS>& steps) const noexcept {
+        for (int i = 0; i < Sequencer::MAX_STEPS; ++i) {
+            steps[static_cast<size_t>(i)] = step(i);
+        }
+    }
+
+    [[nodiscard]] PatternState state() const noexcept {
+        PatternState state;
+        copyTo(state.steps);
+        state.drums = drums;
+        state.sixteenStepMode = sixteenStepMode;
+        return state;
+    }
+};
+
+// Bounded undo/redo over pattern snapshots. Not thread-safe: owned by the UI thread.
+class PatternHistory final {
+public:
+    static constexpr size_t MAX_DEPTH = 64;
+    using SnapshotPtr = std::shared_ptr<const PatternSnapshot>;
+
+    // Makes the given pattern the current version. Returns false if it matches the current one.
+    bool commit(const PatternState& state) {
+        SnapshotPtr next = build(state);
+        if (!next) return false;
+        if (head) {
+            push(undoStack, head);
+            redoStack.clear();
+        }
+        head = std::move(next);
+        return true;
+    }
+
+    // Replaces the current version without recording an undo step (patch load).
+    void reset(const PatternState& state) {
+        undoStack.clear();
+        redoStack.clear();
+        head.reset();
+        head = build(state);
+    }
+
+    [[nodiscard]] SnapshotPtr undo() {
+        if (undoStack.empty()) return nullptr;
+        push(redoStack, head);
+        head = std::move(undoStack.back());
+        undoStack.pop_back();
+        return head;
+    }
+
+    [[nodiscard]] SnapshotPtr redo() {
+        if (redoStack.empty()) return nullptr;
+        push(undoStack, head);
+        head = std::move(redoStack.back());
+        redoStack.pop_back();
+        return head;
+    }
+
+    // A snapshot of the state that shares its unchanged blocks with the current version.
+    [[nodiscard]] SnapshotPtr snapshot(const PatternState& state) const {
+        SnapshotPtr next = build(state);
+        return next ? next : head;
+    }
+
+    [[nodiscard]] SnapshotPtr current() const noexcept { return head; }
+    [[nodiscard]] bool canUndo() const noexcept { return !undoStack.empty(); }
+    [[nodiscard]] bool canRedo() const noexcept { return !redoStack.empty(); }
+    [[nodiscard]] size_t undoDepth() const noexcept { return undoStack.size(); }
+    [[nodiscard]] size_t redoDepth() const noexcept { return redoStack.size(); }
+
+private:
+    SnapshotPtr head;
+    std::deque<SnapshotPtr> undoStack;
+    std::deque<SnapshotPtr> redoStack;
+
+    static void push(std::deque<SnapshotPtr>& stack, SnapshotPtr snapshot) {
+        stack.push_back(std::move(snapshot));
+        if (stack.size() > MAX_DEPTH) stack.pop_front();
+    }
+
+    // Returns nullptr when nothing differs from head.
+    [[nodiscard]] SnapshotPtr build(const PatternState& state) const {
+        auto next = std::make_shared<PatternSnapshot>();
+        next->drums = state.drums;
+        next->sixteenStepMode = state.sixteenStepMode;
+        bool changed = !head || head->drums != state.drums || head->sixteenStepMode != state.sixteenStepMode;
+
+        for (int b = 0; b < PatternSnapshot::BLOCKS; ++b) {
+            PatternSnapshot::StepBlock block;
+            std::copy_n(state.steps.begin() + b * PatternSnapshot::BLOCK_SIZE, PatternSnapshot::BLOCK_SIZE, block.begin());
+            const auto& shared = head ? head->blocks[static_cast<size_t>(b)] : nullptr;
+            if (shared && *shared == block) {
+                next->blocks[static_cast<size_t>(b)] = shared;
+            } else {
+                next->blocks[static_cast<size_t>(b)] = std::make_shared<const PatternSnapshot::StepBlock>(block);
+                changed = true;
+            }
+        }
+        return changed ? next : nullptr;
+    }
+};
+
+// A pattern as the audio thread left it after an edit. `basis` is the last handoff sequence
+// it had applied, `generation` changes whenever a patch load replaces the pattern wholesale.
+struct PatternEdit final {
+    PatternState state;
+    uint32_t basis = 0;
+    uint32_t generation = 0;
+};
+
+// Audio thread to UI thread: a triple buffer holding the newest edit. Each side owns one slot
+// and swaps it with the shared middle slot, so a slot is only ever touched by one thread and
+// the reader never sees a half-written pattern. Neither side locks or allocates.
+class PatternMailbox final {
+public:
+    // Writer: fill the slot returned by edit(), then publish() it.
+    [[nodiscard]] PatternEdit& edit() noexcept { return slots[writeIndex]; }
+
+    void publish() noexcept {
+        writeIndex = shared.exchange(static_cast<uint8_t>(writeIndex | FRESH), std::memory_order_acq_rel) & INDEX;
+    }
+
+    // Reader: the newest published edit, or nullptr if nothing was published since the last call.
+    [[nodiscard]] const PatternEdit* take() noexcept {
+        if ((shared.load(std::memory_order_relaxed) & FRESH) == 0) return nullptr;
+        readIndex = shared.exchange(readIndex, std::memory_order_acq_rel) & INDEX;
+        return &slots[readIndex];
+    }
+
+private:
+    static constexpr uint8_t INDEX = 3;
+    static constexpr uint8_t FRESH = 4;
+
+    std::array<PatternEdit, 3> slots{};
+    std::atomic<uint8_t> shared{1};
+    uint8_t writeIndex = 0;
+    uint8_t readIndex = 2;
+};
+
+// UI thread to audio thread: publishes snapshots (undo, redo, import) for the audio thread to
+// adopt. A publication is only freed once the audio thread has acknowledged it or a later one,
+// and always on the UI thread, so the audio thread never reads or frees released memory.
+class PatternHandoff final {
+public:
+    struct Publication {
+        PatternHistory::SnapshotPtr snapshot;
+        uint32_t sequence = 0;
+        // Imports come back to the UI as an edit so they get their own undo step.
+        bool recordsEdit = false;
+    };
+
+    // UI thread.
+    void publish(PatternHistory::SnapshotPtr snapshot, bool recordsEdit) {
+        collect();
+        uint32_t sequence = published.load(std::memory_order_relaxed) + 1;
+        live.push_back(std::make_unique<Publication>(Publication{std::move(snapshot), sequence, recordsEdit}));
+        published.store(sequence, std::memory_order_relaxed);
+        pending.store(live.back().get(), std::memory_order_release);
+    }
+
+    // UI thread: releases every publication the audio thread is done with.
+    void collect() {
+        uint32_t done = acknowledged.load(std::memory_order_acquire);
+        live.erase(std::remove_if(live.begin(), live.end(), [done](const std::unique_ptr<Publication>& p) {
+            return static_cast<int32_t>(p->sequence - done) <= 0;
+        }), live.end());
+    }
+
+    // Audio thread: the newest publication not yet applied, or nullptr.
+    [[nodiscard]] const Publication* take() const noexcept {
+        return pending.load(std::memory_order_acquire);
+    }
+
+    // Audio thread, once it no longer reads the publication.
+    void acknowledge(const Publication* publication) noexcept {
+        uint32_t sequence = publication->sequence;
+        pending.compare_exchange_strong(publication, nullptr, std::memory_order_acq_rel);
+        acknowledged.store(sequence, std::memory_order_release);
+    }
+
+    // Drops an unapplied publication (patch load) and returns the sequence the loaded pattern
+    // supersedes.
+    uint32_t discard() noexcept {
+        pending.store(nullptr, std::memory_order_release);
+        return published.load(std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] uint32_t latest() const noexcept { return published.load(std::memory_order_relaxed); }
+    [[nodiscard]] size_t retained() const noexcept { return live.size(); }
+
+private:
+    std::atomic<const Publication*> pending{nullptr};
+    std::atomic<uint32_t> acknowledged{0};
+    std::atomic<uint32_t> published{0};
+    std::vector<std::unique_ptr<Publication>> live;
+};
+}
@@ -1,5 +1,9 @@
 #pragma once
+#include <rack.hpp>
+#include <algorithm>
 #include <array>
+#include <cstdint>
+#include "../../constants.hpp"
 
 namespace clonotribe {
 
@@ -22,6 +26,14 @@ struct Sequencer final {
     static constexpr int DEFAULT_STEPS = 8;
     static constexpr int BUFFER_SIZE = 1600;
 
+    [[nodiscard]] static constexpr std::array<int8_t, MAX_STEPS> makeStepTable(int count) noexcept {
+        std::array<int8_t, MAX_STEPS> table{};
+        for (int i = 0; i < count; ++i) {
+            table[i] = static_cast<int8_t>((i + 1) % count);
+        }
+        return table;
+    }
+
     struct Step {
         bool skipped = false;
         bool muted = false;
@@ -30,6 +42,8 @@ struct Sequencer final {
         float gateTime = HALF;
         bool accent = false;
         bool glide = false;
+
+        bool operator==(const Step&) const noexcept = default;
     };
 
     void setStepAccent(int step, bool value) noexcept {
@@ -50,6 +64,11 @@ struct Sequencer final {
     std::array<Step, MAX_STEPS> steps{};
     std::array<float, BUFFER_SIZE> fluxBuffer{};
 
+    // Skip flags as a bit mask plus, for every step, the next step that is not skipped.
+    // Rebuilt by updateStepTable() whenever skip flags or the step count change.
+    uint32_t skipMask = 0;
+    std::array<int8_t, MAX_STEPS> nextActiveStep = makeStepTable(DEFAULT_STEPS);
+
     int currentStep = 0;
     int fluxRecordingStep = 0;
     int fluxSampleCount = 0;
@@ -81,7 +100,10 @@ struct Sequencer final {
 
     void setTempo(float bpm) noexcept { stepDuration = 60.0f / (bpm * 4.0f); }
     void setExternalSync(bool external) noexcept { externalSync = external; }
-    void setSixteenStepMode(bool sixteenStep) noexcept { sixteenStepMode = sixteenStep; }
+    void setSixteenStepMode(bool sixteenStep) noexcept {
+        sixteenStepMode = sixteenStep;
+        updateStepTable();
+    }
     [[nodiscard]] bool isInSixteenStepMode() const noexcept { return sixteenStepMode; }
     void setMatchSteps(bool v) noexcept { matchSteps = v; }
     [[nodiscard]] bool isMatchSteps() const noexcept { return matchSteps; }
@@ -95,14 +117,48 @@ struct Sequencer final {
         return buttonStep * 2 + (isSubStep ? 1 : 0);
     }
     void setStepSkipped(int step, bool skip) noexcept {
-        if (step >= 0 && step < getStepCount()) steps[step].skipped = skip;
+        if (step >= 0 && step < getStepCount() && steps[step].skipped != skip) {
+            steps[step].skipped = skip;
+            updateStepTable();
+        }
     }
     bool isStepSkipped(int step) const noexcept {
         if (step >= 0 && step < getStepCount()) return steps[step].skipped;
         return false;
     }
     void toggleStepSkipped(int step) noexcept {
-        if (step >= 0 && step < getStepCount()) steps[step].skipped = !steps[step].skipped;
+        if (step >= 0 && step < getStepCount()) setStepSkipped(step, !steps[step].skipped);
+    }
+
+    // Call after writing steps[].skipped directly (patch load, randomize, pattern import).
+    void updateStepTable() noexcept {
+        int count = getStepCount();
+        skipMask = 0;
+        for (int i = 0; i < count; ++i) {
+            if (steps[i].skipped) skipMask |= 1u << i;
+        }
+        int next = -1;
+        for (int pass = 0; pass < 2; ++pass) {
+            for (int i = count - 1; i >= 0; --i) {
+                nextActiveStep[i] = static_cast<int8_t>(next >= 0 ? next : i);
+                if (!steps[i].skipped) next = i;
+            }
+        }
+    }
+
+    [[nodiscard]] int getNextActiveStep(int fromStep) const noexcept {
+        return (fromStep >= 0 && fromStep < getStepCount()) ? nextActiveStep[fromStep] : fromStep;
+    }
+
+    // The step itself when it plays, otherwise the next one that does.
+    [[nodiscard]] int findActiveStep(int step) const noexcept {
+        if (step < 0 || step >= getStepCount() || !steps[step].skipped) return step;
+        return nextActiveStep[step];
+    }
+
+    [[nodiscard]] bool allStepsSkipped() const noexcept {
+        uint32_t countMask = (1u << getStepCount()) - 1;
+        return (skipMask & countMask) == countMask;
     }
 
     void setStepMuted(int step, bool mute) noexcept {
@@ -150,6 +206,7 @@ struct Sequencer final {
         fluxMode = false;
         fluxStepTimer = ZERO;
         std::fill(std::begin(fluxBuffer), std::end(fluxBuffer), ZERO);
+        updateStepTable();
     }
     
     void enableAllSteps() noexcept {
@@ -157,6 +214,7 @@ struct Sequencer final {
         for (int i = 0; i < stepCount; i++) {
             steps[i].skipped = false;
         }
+        updateStepTable();
     }
     
     void recordNote(float pitch, float gate, float gateTime = HALF) noexcept {
@@ -166,8 +224,8 @@ struct Sequencer final {
                 steps[targetStep].pitch = pitch;
                 steps[targetStep].gate = gate;
                 steps[targetStep].gateTime = gateTime;
-                steps[targetStep].skipped = false;
                 steps[targetStep].muted = false;
+                setStepSkipped(targetStep, false);
             }
         }
     }
@@ -176,8 +234,8 @@ struct Sequencer final {
             steps[step].pitch = pitch;
             steps[step].gate = gate;
             steps[step].gateTime = gateTime;
-            steps[step].skipped = false;
             steps[step].muted = false;
+            setStepSkipped(step, false);
         }
     }
     void recordFlux(float pitch) noexcept {
@@ -210,15 +268,6 @@ struct Sequencer final {
         SequencerOutput output;
         if (!playing) return output;
         bool wasNewStep = false;
-        auto advanceToNextActiveStep = [this](int fromStep) -> int {
-            int count = getStepCount();
-            int next = (fromStep + 1) % count;
-            for (int i = 0; i < count; ++i) {
-                if (!steps[next].skipped) return next;
-                next = (next + 1) % count;
-            }
-            return fromStep;
-        };
         if (externalSync) {
             bool syncTriggered = syncTrigger.process(syncSignal > ONE);
             if (syncTriggered) {
@@ -235,7 +284,7 @@ struct Sequencer final {
                     }
                 }
                 if (!applied) {
-                    int nextStep = advanceToNextActiveStep(currentStep);
+                    int nextStep = getNextActiveStep(currentStep);
                     wasNewStep = (nextStep != currentStep);
                     currentStep = nextStep;
                     stepTimer = ZERO;
@@ -246,7 +295,7 @@ struct Sequencer final {
             stepTimer += sampleTime;
             if (stepTimer >= stepDuration) {
                 stepTimer -= stepDuration;
-                int nextStep = advanceToNextActiveStep(currentStep);
+                int nextStep = getNextActiveStep(currentStep);
                 wasNewStep = (nextStep != currentStep);
                 currentStep = nextStep;
             }
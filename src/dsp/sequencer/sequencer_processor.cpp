@@ -17,45 +17,35 @@ void Clonotribe::handleSequencerAndDrumState(clonotribe::Sequencer::SequencerOut
         } else if(gateTriggered) {
             if (sequencer.playing) {
                 sequencer.recordNote(finalInputPitch, finalGate > ONE ? finalGate : 5.0f, 0.8f);
+                markPatternEdited();
             } else {
                 int stepCount = sequencer.getStepCount();
-                int nextStep = sequencer.recordingStep;
-                for (int i = 0; i < stepCount; ++i) {
-                    if (!sequencer.isStepSkipped(nextStep)) break;
-                    nextStep = (nextStep + 1) % stepCount;
-                }
-                bool allSkipped = true;
-                for (int i = 0; i < stepCount; ++i) {
-                    if (!sequencer.isStepSkipped(i)) { allSkipped = false; break; }
-                }
-                if (allSkipped) {
+                int nextStep;
+                if (sequencer.allStepsSkipped()) {
                     sequencer.setStepSkipped(0, false);
                     nextStep = 0;
+                } else {
+                    nextStep = sequencer.findActiveStep(sequencer.recordingStep);
                 }
                 sequencer.recordNoteToStep(nextStep, finalInputPitch, finalGate > ONE ? finalGate : 5.0f, 0.8f);
                 sequencer.recordingStep = (nextStep + 1) % stepCount;
+                markPatternEdited();
             }
         } else if (sequencer.playing && ribbon.touching && seqOutput.stepChanged) {
             sequencer.recordNote(finalInputPitch, finalGate > ONE ? finalGate : 5.0f, 0.8f);
+            markPatternEdited();
         }
     }
 
     if (sequencer.playing && seqOutput.stepChanged) {
         int currentStep = seqOutput.step;
-
-        int drumStepIndex = currentStep;
-        if (sequencer.isInSixteenStepMode()) {
-            if (currentStep % 2 == 0 && currentStep < 16) {
-                drumStepIndex = currentStep >> 1;
-            } else {
-                drumStepIndex = -1;
-            }
-        }
-
-        if (drumStepIndex >= 0 && drumStepIndex < 8 && !sequencer.isStepSkipped(currentStep)) {
-            if (drumPatterns[0][drumStepIndex]) triggerKick();
-            if (drumPatterns[1][drumStepIndex]) triggerSnare();
-            if (drumPatterns[2][drumStepIndex]) triggerHihat();
+        uint32_t lanes = sequencer.isStepSkipped(currentStep) ? 0u : drumPattern.lanesAt(currentStep);
+        if (lanes != 0) {
+            uint32_t accents = drumPattern.accentsAt(currentStep);
+            float accentAmount = paramCache.accentGlideAmount;
+            if (lanes & 1u) triggerKick((accents & 1u) ? accentAmount : ZERO);
+            if (lanes & 2u) triggerSnare((accents & 2u) ? accentAmount : ZERO);
+            if (lanes & 4u) triggerHihat((accents & 4u) ? accentAmount : ZERO);
         }
         syncPulse.trigger(1e-3f);
     }
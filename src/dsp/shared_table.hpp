@@ -0,0 +1,75 @@
+#pragma once
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace clonotribe {
+
+// Handle to a process-wide, immutable T shared by every module instance. The first handle
+// builds T (under a lock, so instances created on different threads still build it once),
+// later handles share it, and it is freed when the last handle goes away. Tables are
+// expected to be alignas(64) so they start on their own cache line.
+// With a Key (e.g. the sample rate) there is one table per key value, built as T(key).
+template<typename T, typename Key = void>
+class SharedTable final {
+public:
+    template<typename K = Key, std::enable_if_t<std::is_void_v<K>, int> = 0>
+    SharedTable() : table(acquire()) {}
+
+    template<typename K = Key, std::enable_if_t<!std::is_void_v<K>, int> = 0>
+    explicit SharedTable(const K& key) : table(acquire(key)) {}
+
+    [[nodiscard]] const T& operator*() const noexcept { return *table; }
+    [[nodiscard]] const T* operator->() const noexcept { return table.get(); }
+    [[nodiscard]] const T* get() const noexcept { return table.get(); }
+
+    // Number of handles currently sharing the table for this key.
+    template<typename... K>
+    [[nodiscard]] static long users(const K&... key) {
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        auto it = r.find(key...);
+        return it == r.tables.end() ? 0 : it->second.use_count();
+    }
+
+private:
+    using Slot = std::conditional_t<std::is_void_v<Key>, char, Key>;
+
+    struct Registry {
+        std::mutex mutex;
+        std::vector<std::pair<Slot, std::weak_ptr<const T>>> tables;
+
+        template<typename... K>
+        auto find(const K&... key) {
+            return std::find_if(tables.begin(), tables.end(), [&](const auto& entry) {
+                return ((entry.first == key) && ... && true);
+            });
+        }
+    };
+
+    std::shared_ptr<const T> table;
+
+    static Registry& registry() {
+        static Registry instance;
+        return instance;
+    }
+
+    template<typename... K>
+    static std::shared_ptr<const T> acquire(const K&... key) {
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        auto it = r.find(key...);
+        std::shared_ptr<const T> shared = it == r.tables.end() ? nullptr : it->second.lock();
+        if (!shared) {
+            shared = std::shared_ptr<const T>(new T(key...));
+            r.tables.erase(std::remove_if(r.tables.begin(), r.tables.end(),
+                [](const auto& entry) { return entry.second.expired(); }), r.tables.end());
+            r.tables.emplace_back(Slot{key...}, shared);
+        }
+        return shared;
+    }
+};
+}
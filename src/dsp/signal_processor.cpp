@@ -1,61 +1,36 @@
 #include "../clonotribe.hpp"
 #include "envelope.hpp"
 
-float Clonotribe::processEnvelope(Envelope::Type envelopeType, Envelope& envelope, float sampleTime, float finalSequencerGate) {
-    float envValue = ONE;
-    bool useGate = (finalSequencerGate > ONE);
-    switch (envelopeType) {
-        case Envelope::Type::ATTACK:
-            envelope.setAttack(0.1f);
-            envelope.setDecay(0.1f);
-            envelope.setSustain(ONE);
-            envelope.setRelease(0.1f);
-            envValue = envelope.process(sampleTime);
-            break;
-        case Envelope::Type::GATE:
-            envValue = useGate ? ONE : ZERO;
-            break;
-        case Envelope::Type::DECAY:
-            envelope.setAttack(0.001f);
-            envelope.setDecay(0.5f);
-            envelope.setSustain(ZERO);
-            envelope.setRelease(0.001f);
-            envValue = envelope.process(sampleTime);
-            break;
-        default:
-            break;
+// Runs inside the oversampled voice, on the VCA-scaled filter output.
+[[nodiscard]] float Clonotribe::processDistortion(float synthOutput, float distortion) {
+    if (distortion <= ZERO) {
+        return synthOutput;
     }
-    return envValue;
+    float driveGain = ONE + (distortion * TWO);
+    float drivenSignal = synthOutput * driveGain;
+    float distortedSignal = distortionProcessor.process(drivenSignal, distortion);
+    float outputLevel = std::abs(synthOutput);
+    float distortedLevel = std::abs(distortedSignal);
+    
+    if (outputLevel > 0.0001f && distortedLevel > outputLevel * 3.0f) {
+        float excessGain = distortedLevel / (outputLevel * 2.5f);
+        float compressionFactor = ONE + std::sqrt(excessGain - ONE) * HALF;
+        distortedSignal /= compressionFactor;
+    }
+    return distortedSignal;
 }
 
-[[nodiscard]] float Clonotribe::processOutput(
-    float filteredSignal, float volume, float envValue, float ribbonVolumeAutomation,
-    float rhythmVolume, float sampleTime, NoiseGenerator& noiseGenerator, int currentStep, float distortion,
+[[nodiscard]] float_4 Clonotribe::processOutput(
+    float synthOutput, float rhythmVolume, float sampleTime, NoiseGenerator& noiseGenerator, int currentStep, float distortion,
     float delayClock, float delayTime, float delayAmount
 ) {
-    float volumeModulation = ONE + (ribbonVolumeAutomation * HALF);
-    volumeModulation = std::clamp(volumeModulation, 0.1f, TWO);
-    
-    float synthOutput = filteredSignal * volume * envValue * volumeModulation;
-    
     if (distortion > ZERO) {
-        float driveGain = ONE + (distortion * TWO);
-        float drivenSignal = synthOutput * driveGain;
-        float distortedSignal = distortionProcessor.process(drivenSignal, distortion);
-        float outputLevel = std::abs(synthOutput);
-        float distortedLevel = std::abs(distortedSignal);
-        
-        if (outputLevel > 0.0001f && distortedLevel > outputLevel * 3.0f) {
-            float excessGain = distortedLevel / (outputLevel * 2.5f);
-            float compressionFactor = ONE + std::sqrt(excessGain - ONE) * HALF;
-            distortedSignal /= compressionFactor;
-        }
-        
-        synthOutput = dcBlockerPostDist.processAggressive(distortedSignal);
+        synthOutput = dcBlockerPostDist.processAggressive(synthOutput);
     }
     
+    float_4 synthStereo = float_4(synthOutput, synthOutput, ZERO, ZERO);
     if (delayAmount > ZERO && delayTime > 0.001f) {
-        synthOutput = delayProcessor.process(synthOutput, delayClock, delayTime, delayAmount);
+        synthStereo = delayProcessor.processStereo(synthOutput, delayClock, delayTime, delayAmount);
     }
 
     float drumMix = ZERO;
@@ -75,8 +50,12 @@ float Clonotribe::processEnvelope(Envelope::Type envelopeType, Envelope& envelop
         outputs[OUTPUT_HIHAT_CONNECTOR].setVoltage(ZERO);
     }
     
-    outputs[OUTPUT_SYNTH_CONNECTOR].setVoltage(std::clamp(synthOutput * 4.0f, -10.0f, 10.0f));
+    bool stereo = delayProcessor.getStereo() != Delay::Stereo::MONO;
+    outputs[OUTPUT_SYNTH_CONNECTOR].setChannels(stereo ? 2 : 1);
+    outputs[OUTPUT_SYNTH_CONNECTOR].setVoltage(std::clamp(synthStereo[0] * 4.0f, -10.0f, 10.0f), 0);
+    if (stereo) {
+        outputs[OUTPUT_SYNTH_CONNECTOR].setVoltage(std::clamp(synthStereo[1] * 4.0f, -10.0f, 10.0f), 1);
+    }
     
-    float synthLevel = synthOutput * 0.8f;
-    return synthLevel + drumMix;
+    return synthStereo * 0.8f + float_4(drumMix);
 }
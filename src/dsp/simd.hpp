@@ -0,0 +1,32 @@
+#pragma once
+#include <simd/Vector.hpp>
+#include <simd/functions.hpp>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace clonotribe {
+
+using float_4 = rack::simd::float_4;
+
+#if defined(__AVX2__)
+// 8-lane float vector for code compiled with AVX2; only the operations the DSP kernels use.
+struct float_8 {
+    __m256 v;
+
+    float_8() noexcept = default;
+    float_8(__m256 v) noexcept : v(v) {}
+    float_8(float x) noexcept : v(_mm256_set1_ps(x)) {}
+
+    [[nodiscard]] static float_8 load(const float* p) noexcept { return _mm256_loadu_ps(p); }
+    void store(float* p) const noexcept { _mm256_storeu_ps(p, v); }
+
+    friend float_8 operator+(float_8 a, float_8 b) noexcept { return _mm256_add_ps(a.v, b.v); }
+    friend float_8 operator-(float_8 a, float_8 b) noexcept { return _mm256_sub_ps(a.v, b.v); }
+    friend float_8 operator*(float_8 a, float_8 b) noexcept { return _mm256_mul_ps(a.v, b.v); }
+    friend float_8 operator/(float_8 a, float_8 b) noexcept { return _mm256_div_ps(a.v, b.v); }
+    friend float_8 operator-(float_8 a) noexcept { return _mm256_sub_ps(_mm256_setzero_ps(), a.v); }
+};
+#endif
+
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include "../fastmath.hpp"
+#include "../simd.hpp"
+
+namespace clonotribe {
+
+// The cutoff-dependent coefficients of all three filter models at one sample rate, tabulated
+// over the normalized cutoff and read with linear interpolation, so modulating the cutoff
+// costs no exp() or sin(). FilterProcessor shares one table per sample rate; the row
+// functions are the exact formulas, used to build it and by filters running without it.
+struct alignas(64) FilterCoefficientTable final {
+    static constexpr int POINTS = 1025;
+    static constexpr float MIN_SAMPLE_RATE = 8000.f;
+
+    const float sampleRate;
+    // MS20: {f, cutoff fade, oscillator increment, G}
+    std::array<float_4, POINTS> ms20{};
+    // Ladder: {f, G, 0, 0}
+    // G = g / (1 + g) is the TPT one-pole gain of the ZDF solver, g = tan(pi fc / fs) its
+    // integrator gain. Unlike g, G stays bounded and smooth enough to interpolate near Nyquist.
+    std::array<float_4, POINTS> ladder{};
+    // Moog: {f, feedback scale, 0, 0}; the feedback is resonance times the scale.
+    std::array<float_4, POINTS> moog{};
+
+    explicit FilterCoefficientTable(float sampleRate) noexcept : sampleRate(sampleRate) {
+        for (int i = 0; i < POINTS; ++i) {
+            float param = static_cast<float>(i) / static_cast<float>(POINTS - 1);
+            auto index = static_cast<size_t>(i);
+            ms20[index] = ms20Row(param, sampleRate);
+            ladder[index] = ladderRow(param, sampleRate);
+            moog[index] = moogRow(param, sampleRate);
+        }
+    }
+
+    [[nodiscard]] float_4 ms20At(float param) const noexcept { return interpolate(ms20, param); }
+    [[nodiscard]] float_4 ladderAt(float param) const noexcept { return interpolate(ladder, param); }
+    [[nodiscard]] float_4 moogAt(float param) const noexcept { return interpolate(moog, param); }
+
+    [[nodiscard]] static float_4 ms20Row(float param, float sampleRate) noexcept {
+        float cutoff = std::clamp(20.f * std::exp(7.0f * std::max(param, 0.001f)), 20.f, sampleRate * 0.35f);
+        float invSampleRate = ONE / sampleRate;
+        float f = std::clamp(TWO * FastMath::fastSin(FastMath::PI * cutoff * invSampleRate), 0.f, 0.9f);
+        float gain = zdfGain(20.f * std::exp(7.0f * std::max(param, 0.001f)), sampleRate);
+        float fade = ONE;
+        if (param < 0.3f) {
+            fade = ZERO;
+        } else if (param < 0.4f) {
+            float fadeAmount = (param - 0.3f) * 10.0f;
+            fade = MIN + fadeAmount * fadeAmount * 0.99f;
+        }
+        return float_4(f, fade, TWO * FastMath::PI * cutoff * invSampleRate, gain);
+    }
+
+    [[nodiscard]] static float_4 ladderRow(float param, float sampleRate) noexcept {
+        float cutoff = 20.f * std::exp(7.0f * param);
+        float f = std::clamp(TWO * FastMath::fastSin(FastMath::PI * cutoff * FastMath::fastInverse(sampleRate)), 0.f, 0.99f);
+        return float_4(f, zdfGain(cutoff, sampleRate), ZERO, ZERO);
+    }
+
+    [[nodiscard]] static float_4 moogRow(float param, float sampleRate) noexcept {
+        float cutoff = 20.f * std::exp(7.0f * param);
+        float f = cutoff * FastMath::fastInverse(sampleRate) * 1.16f;
+        return float_4(f, 4.0f * (ONE - 0.15f * f * f), ZERO, ZERO);
+    }
+
+private:
+    [[nodiscard]] static float zdfGain(float cutoff, float sampleRate) noexcept {
+        float g = std::tan(FastMath::PI * std::clamp(cutoff, 20.f, sampleRate * 0.45f) / sampleRate);
+        return g / (ONE + g);
+    }
+
+    [[nodiscard]] static float_4 interpolate(const std::array<float_4, POINTS>& rows, float param) noexcept {
+        float x = std::clamp(param, ZERO, ONE) * static_cast<float>(POINTS - 1);
+        int k = std::min(static_cast<int>(x), POINTS - 2);
+        float t = x - static_cast<float>(k);
+        const float_4 lower = rows[static_cast<size_t>(k)];
+        return lower + (rows[static_cast<size_t>(k + 1)] - lower) * t;
+    }
+};
+}
@@ -7,4 +7,11 @@ enum class FilterType {
 	MOOG = 2,
 	COUNT = 3
 };
+
+// How the MS20 and Ladder models integrate: EULER is the original explicit update, ZDF the
+// zero-delay-feedback (TPT) form that stays tuned and stable up to Nyquist.
+enum class FilterSolver {
+	EULER = 0,
+	ZDF = 1
+};
 }
\ No newline at end of file
@@ -4,24 +4,42 @@
 #include <algorithm>
 #include <cmath>
 #include "../fastmath.hpp"
+#include "filter_coefficients.hpp"
+#include "filter_type.hpp"
 
 namespace clonotribe {
 
-class LadderFilter {
+// Runs on float or on float_4 lanes that share one set of coefficients.
+template<typename T = float>
+class TLadderFilter {
 public:
-    LadderFilter() = default;
+    TLadderFilter() noexcept {
+        updateCoefficients();
+    }
 
     void setSampleRate(float sr) noexcept {
-        sampleRate = std::max(8000.f, sr);
-        invSampleRate = FastMath::fastInverse(sampleRate);
+        sampleRate = std::max(FilterCoefficientTable::MIN_SAMPLE_RATE, sr);
+        updateCoefficients();
+    }
+
+    // Shared table for the current sample rate; a table for another rate is ignored.
+    void setCoefficientTable(const FilterCoefficientTable* table) noexcept {
+        coefficientTable = table;
+        updateCoefficients();
     }
 
     void setCutoff(float param) noexcept {
-        cutoffParam = std::clamp(param, 0.f, ONE);
+        param = std::clamp(param, 0.f, ONE);
+        if (param == cutoffParam) return;
+        cutoffParam = param;
+        updateCoefficients();
     }
 
     void setResonance(float param) noexcept {
-        resonanceParam = std::clamp(param, 0.f, ONE);
+        param = std::clamp(param, 0.f, ONE);
+        if (param == resonanceParam) return;
+        resonanceParam = param;
+        updateCoefficients();
     }
 
     void setActive(bool isActive) noexcept {
@@ -29,30 +47,79 @@ public:
         if (!active) reset();
     }
 
-    [[nodiscard]] float process(float input) noexcept {
-        if (!active) return ZERO;
-        float cutoff = 20.f * std::exp(7.0f * cutoffParam);
-        float res = resonanceParam * 4.0f;
-        float f = TWO * FastMath::fastSin(FastMath::PI * cutoff * invSampleRate);
-        f = std::clamp(f, 0.f, 0.99f);
-        float x = input - res * y4;
-        y1 += f * (FastMath::fastTanh(x - y1));
-        y2 += f * (FastMath::fastTanh(y1 - y2));
-        y3 += f * (FastMath::fastTanh(y2 - y3));
-        y4 += f * (FastMath::fastTanh(y3 - y4));
-        return y4;
+    // y1..y4 hold the stage outputs for EULER and the integrator states for ZDF; close enough
+    // to switch without a reset.
+    void setSolver(FilterSolver solver) noexcept { this->solver = solver; }
+    [[nodiscard]] FilterSolver getSolver() const noexcept { return solver; }
+
+    [[nodiscard]] T process(T input) noexcept {
+        if (!active) return T(ZERO);
+        return solver == FilterSolver::ZDF ? stepZdf(input) : stepEuler(input);
     }
 
     void reset() noexcept {
-        y1 = y2 = y3 = y4 = ZERO;
+        y1 = y2 = y3 = y4 = feedback = T(ZERO);
+    }
+
+    // Starts with every stage settled at this level, e.g. another model's last output.
+    void seed(T level) noexcept {
+        y1 = y2 = y3 = y4 = level;
+        feedback = T(ZERO);
     }
 
 private:
-    float y1 = 0.f, y2 = 0.f, y3 = 0.f, y4 = ZERO;
+    T y1 = T(ZERO), y2 = T(ZERO), y3 = T(ZERO), y4 = T(ZERO);
+    T feedback = T(ZERO);
+    FilterSolver solver = FilterSolver::EULER;
     float cutoffParam = HALF;
     float resonanceParam = ZERO;
     float sampleRate = 44100.f;
-    float invSampleRate = FastMath::fastInverse(44100.f);
     bool active = true;
+    const FilterCoefficientTable* coefficientTable = nullptr;
+    float f = ZERO;
+    float res = ZERO;
+    float stageGain = ZERO;
+    float loopGain = ZERO;
+
+    [[nodiscard]] T stepEuler(T input) noexcept {
+        T x = input - res * y4;
+        y1 += f * (FastMath::fastTanh(x - y1));
+        y2 += f * (FastMath::fastTanh(y1 - y2));
+        y3 += f * (FastMath::fastTanh(y2 - y3));
+        y4 += f * (FastMath::fastTanh(y3 - y4));
+        return y4;
+    }
+
+    // Four linear TPT one-poles, G = g / (1 + g), with the tanh at the input inside the loop:
+    // u = tanh(x - res * y4) and y4 = G^4 u + S, where S collects the stage states.
+    // One Newton step on u, starting from the previous sample's u.
+    [[nodiscard]] T stepZdf(T input) noexcept {
+        const float G = stageGain;
+        const T states = (((y1 * G + y2) * G + y3) * G + y4) * (ONE - G);
+        T u = feedback;
+        const T t = FastMath::fastTanh(input - res * (loopGain * u + states));
+        u -= (u - t) / (ONE + res * loopGain * (ONE - t * t));
+        feedback = u;
+        return stage(stage(stage(stage(u, y1), y2), y3), y4);
+    }
+
+    [[nodiscard]] T stage(T x, T& state) const noexcept {
+        T v = (x - state) * stageGain;
+        T y = v + state;
+        state = y + v;
+        return y;
+    }
+
+    void updateCoefficients() noexcept {
+        float_4 row = coefficientTable && coefficientTable->sampleRate == sampleRate
+            ? coefficientTable->ladderAt(cutoffParam)
+            : FilterCoefficientTable::ladderRow(cutoffParam, sampleRate);
+        f = row[0];
+        res = resonanceParam * 4.0f;
+        stageGain = row[1];
+        loopGain = stageGain * stageGain * stageGain * stageGain;
+    }
 };
-}
\ No newline at end of file
+
+using LadderFilter = TLadderFilter<>;
+}
@@ -2,23 +2,42 @@
 #include <algorithm>
 #include <cmath>
 #include "../fastmath.hpp"
+#include "filter_coefficients.hpp"
+#include "../rate_coefficient.hpp"
 
 namespace clonotribe {
 
-class MoogFilter {
+// Templated on the sample type like TMS20Filter.
+template<typename T = float>
+class TMoogFilter {
 public:
-    MoogFilter() = default;
+    TMoogFilter() noexcept {
+        updateCoefficients();
+    }
+
     void setSampleRate(float sr) noexcept {
-        sampleRate = std::max(8000.f, sr);
-        invSampleRate = FastMath::fastInverse(sampleRate);
+        sampleRate = std::max(FilterCoefficientTable::MIN_SAMPLE_RATE, sr);
+        updateCoefficients();
+    }
+
+    // Shared table for the current sample rate; a table for another rate is ignored.
+    void setCoefficientTable(const FilterCoefficientTable* table) noexcept {
+        coefficientTable = table;
+        updateCoefficients();
     }
 
     void setCutoff(float param) noexcept {
-        cutoffParam = std::clamp(param, 0.f, ONE);
+        param = std::clamp(param, 0.f, ONE);
+        if (param == cutoffParam) return;
+        cutoffParam = param;
+        updateCoefficients();
     }
 
     void setResonance(float param) noexcept {
-        resonanceParam = std::clamp(param, 0.f, ONE);
+        param = std::clamp(param, 0.f, ONE);
+        if (param == resonanceParam) return;
+        resonanceParam = param;
+        updateCoefficients();
     }
 
     void setActive(bool isActive) noexcept {
@@ -26,31 +45,51 @@ public:
         if (!active) reset();
     }
 
-    [[nodiscard]] float process(float input) noexcept {
-        if (!active) return ZERO;
-        float cutoff = 20.f * std::exp(7.0f * cutoffParam);
-        float res = resonanceParam * 4.0f;
-        float f = cutoff * invSampleRate * 1.16f;
-        float fb = res * (ONE - 0.15f * f * f);
-        float in = input - fb * y4;
+    [[nodiscard]] T process(T input) noexcept {
+        if (!active) return T(ZERO);
+        T in = input - fb * y4;
         in = FastMath::fastTanh(in);
-        y1 = FastMath::fastTanh(in * f + FastMath::fastTanh(y1) * (ONE - f));
-        y2 = FastMath::fastTanh(y1 * f + FastMath::fastTanh(y2) * (ONE - f));
-        y3 = FastMath::fastTanh(y2 * f + FastMath::fastTanh(y3) * (ONE - f));
-        y4 = FastMath::fastTanh(y3 * f + FastMath::fastTanh(y4) * (ONE - f));
+        y1 = saturate(in * f + saturate(y1) * (ONE - f));
+        y2 = saturate(y1 * f + saturate(y2) * (ONE - f));
+        y3 = saturate(y2 * f + saturate(y3) * (ONE - f));
+        y4 = saturate(y3 * f + saturate(y4) * (ONE - f));
         return y4;
     }
 
     void reset() noexcept {
-        y1 = y2 = y3 = y4 = ZERO;
+        y1 = y2 = y3 = y4 = T(ZERO);
+    }
+
+    void seed(T level) noexcept {
+        y1 = y2 = y3 = y4 = level;
     }
 
 private:
-    float y1 = 0.f, y2 = 0.f, y3 = 0.f, y4 = ZERO;
+    T y1 = T(ZERO), y2 = T(ZERO), y3 = T(ZERO), y4 = T(ZERO);
     float cutoffParam = HALF;
     float resonanceParam = ZERO;
     float sampleRate = 44100.f;
-    float invSampleRate = FastMath::fastInverse(44100.f);
     bool active = true;
+    const FilterCoefficientTable* coefficientTable = nullptr;
+    float f = ZERO;
+    float fb = ZERO;
+    float saturation = ONE;
+
+    // The stages saturate their state every sample, so the amount is scaled to keep the
+    // compression per second, and with it the response, the same as at the reference rate.
+    [[nodiscard]] T saturate(T x) const noexcept {
+        return FastMath::fastTanh(x) * saturation + x * (ONE - saturation);
+    }
+
+    void updateCoefficients() noexcept {
+        float_4 row = coefficientTable && coefficientTable->sampleRate == sampleRate
+            ? coefficientTable->moogAt(cutoffParam)
+            : FilterCoefficientTable::moogRow(cutoffParam, sampleRate);
+        f = row[0];
+        fb = resonanceParam * row[1];
+        saturation = std::min(ONE, Decay::REFERENCE_RATE / sampleRate);
+    }
 };
-}
\ No newline at end of file
+
+using MoogFilter = TMoogFilter<>;
+}
@@ -1,25 +1,45 @@
 #pragma once
+#include <limits>
+#include <type_traits>
 #include "../fastmath.hpp"
 #include "../noise.hpp"
+#include "filter_coefficients.hpp"
+#include "filter_type.hpp"
 
 namespace clonotribe {
 
-class MS20Filter {
+// T is float or float_4; the coefficients are shared by all lanes, the state is per lane.
+template<typename T = float>
+class TMS20Filter {
 public:
-    MS20Filter() = default;
+    TMS20Filter() noexcept {
+        updateCoefficients();
+    }
 
     void setSampleRate(float sr) noexcept {
-        sampleRate = std::max(8000.f, sr);
-        invSampleRate = ONE / sampleRate;
+        sampleRate = std::max(FilterCoefficientTable::MIN_SAMPLE_RATE, sr);
         noiseGen.setSeed(static_cast<uint32_t>(sr));
+        updateCoefficients();
+    }
+
+    // Shared table for the current sample rate; a table for another rate is ignored.
+    void setCoefficientTable(const FilterCoefficientTable* table) noexcept {
+        coefficientTable = table;
+        updateCoefficients();
     }
 
     void setCutoff(float param) noexcept {
-        cutoffParam = std::clamp(param, 0.f, ONE);
+        param = std::clamp(param, 0.f, ONE);
+        if (param == cutoffParam) return;
+        cutoffParam = param;
+        updateCoefficients();
     }
 
     void setResonance(float param) noexcept {
-        resonanceParam = std::clamp(param, 0.f, ONE);
+        param = std::clamp(param, 0.f, ONE);
+        if (param == resonanceParam) return;
+        resonanceParam = param;
+        updateCoefficients();
     }
 
     void setActive(bool isActive) noexcept {
@@ -27,97 +47,98 @@ public:
         if (!active) reset();
     }
 
-    [[nodiscard]] float process(float input) noexcept {
-        if (!active) {
-            return ZERO;
-        }
-
-        if (std::abs(input) < 1e-30f) {
-            input = ZERO;
-        }
-        if (std::abs(s1) < 1e-30f) {
-            s1 = ZERO;
-        }
-        if (std::abs(s2) < 1e-30f) {
-            s2 = ZERO;
-        }
+    // Both solvers keep the bandpass in s1 and the lowpass in s2, so switching is seamless.
+    void setSolver(FilterSolver solver) noexcept { this->solver = solver; }
+    [[nodiscard]] FilterSolver getSolver() const noexcept { return solver; }
 
-        if (!std::isfinite(input)) {
-            reset();
-            return ZERO;
+    [[nodiscard]] T process(T input) noexcept {
+        if (!active) {
+            return T(ZERO);
         }
 
-        float cutoff = calculateCutoff(cutoffParam);
-        cutoff = std::clamp(cutoff, 20.f, sampleRate * 0.35f);
-
-        float resonance = calculateResonance(resonanceParam);
-        float f = TWO * FastMath::fastSin(FastMath::PI * cutoff * invSampleRate);
-        f = std::clamp(f, 0.f, 0.9f);
+        // Lanes fed a non-finite value restart from silence and output zero.
+        const auto finite = vector_ops::abs(input) <= std::numeric_limits<float>::max();
+        input = vector_ops::select(finite, input, T(ZERO));
+        s1 = vector_ops::select(finite, s1, T(ZERO));
+        s2 = vector_ops::select(finite, s2, T(ZERO));
+        bandpass = vector_ops::select(finite, bandpass, T(ZERO));
 
-        float drive = ONE + resonanceParam * 1.2f;
-        
-        float drivenInput = input * drive;
+        T drivenInput = input * drive;
         drivenInput = saturate(drivenInput);
-        
-        float hp = saturate(drivenInput - resonance * s2 - s1);
-        
-        s1 += f * saturate(hp);
-        s2 += f * saturate(s1);
 
-        float output = s2;
-        
-        if (cutoffParam < 0.4f) {
-            if (cutoffParam < 0.3f) {
-                output *= ZERO;
-            } else {
-                float fadeRange = cutoffParam - 0.3f;
-                float fadeAmount = fadeRange * 10.0f;
-                fadeAmount = fadeAmount * fadeAmount;
-                output *= MIN + fadeAmount * 0.99f;
-            }
-        }
-
-        if (resonanceParam > 0.75f) {
-            float oscGain = (resonanceParam - 0.75f) * 4.0f;
-            oscPhase += TWO * FastMath::PI * cutoff * invSampleRate;
-            if (oscPhase >= TWO * FastMath::PI) oscPhase -= TWO * FastMath::PI;
-            
-            float oscSig = FastMath::fastSin(oscPhase) * oscGain * 0.15f;
+        T output = (solver == FilterSolver::ZDF ? stepZdf(drivenInput) : stepEuler(drivenInput)) * cutoffFade;
 
-            if (cutoff > sampleRate * 0.25f) {
-                oscSig *= HALF;
+        // Self-oscillation. The scalar filter skips it below the threshold; the vector form runs
+        // it unconditionally, with oscStep, the blend and the level neutral below the threshold.
+        if constexpr (std::is_same_v<T, float>) {
+            if (oscGain > ZERO) {
+                oscPhase += oscStep;
+                if (oscPhase >= TWO * FastMath::PI) oscPhase -= TWO * FastMath::PI;
+                output = output * oscBlend + FastMath::fastSin(oscPhase) * oscLevel;
             }
-            
-            output = output * (ONE - oscGain * 0.3f) + oscSig;
+        } else {
+            oscPhase += oscStep;
+            oscPhase -= vector_ops::select(oscPhase >= TWO * FastMath::PI, TWO * FastMath::PI, ZERO);
+            output = output * oscBlend + FastMath::fastSin(oscPhase) * oscLevel;
         }
 
-        if (std::abs(output) < 1e-30f) output = ZERO;
-
-        float finalGain = 1.1f + resonanceParam * 0.3f;
-        output = saturate(output * finalGain);
-        
-        return output;
+        return vector_ops::select(finite, saturate(output * finalGain), T(ZERO));
     }
 
     void reset() noexcept {
-        s1 = s2 = ZERO;
+        s1 = s2 = bandpass = T(ZERO);
         oscPhase = ZERO;
     }
+
+    // Starts from a settled lowpass at this level, e.g. another model's last output.
+    void seed(T level) noexcept {
+        s1 = bandpass = T(ZERO);
+        s2 = level;
+    }
     
 private:
-    float s1 = 0.f, s2 = ZERO;
+    T s1 = T(ZERO), s2 = T(ZERO);
+    T bandpass = T(ZERO);
+    FilterSolver solver = FilterSolver::EULER;
     float cutoffParam = HALF;
     float resonanceParam = ZERO;
     float sampleRate = 44100.f;
-    float invSampleRate = ONE/44100.f;
     float oscPhase = ZERO;
     bool active = true;
 
-    NoiseGenerator noiseGen;
+    // Derived from the parameters and sample rate, so oversampled runs only pay for the kernel.
+    float f = ZERO;
+    float g = ZERO;
+    float resonance = ZERO;
+    float drive = ONE;
+    float cutoffFade = ONE;
+    float oscGain = ZERO;
+    float oscIncrement = ZERO;
+    float oscStep = ZERO;
+    float oscBlend = ONE;
+    float oscLevel = ZERO;
+    float finalGain = ONE;
 
-    [[nodiscard]] inline float calculateCutoff(float param) const noexcept {
-        param = std::clamp(param, 0.001f, ONE);
-        return 20.f * std::exp(7.0f * param);
+    NoiseGenerator noiseGen;
+    const FilterCoefficientTable* coefficientTable = nullptr;
+
+    void updateCoefficients() noexcept {
+        float_4 row = coefficientTable && coefficientTable->sampleRate == sampleRate
+            ? coefficientTable->ms20At(cutoffParam)
+            : FilterCoefficientTable::ms20Row(cutoffParam, sampleRate);
+        f = row[0];
+        cutoffFade = row[1];
+        oscIncrement = row[2];
+        g = row[3] / (ONE - row[3]);
+
+        resonance = calculateResonance(resonanceParam);
+        drive = ONE + resonanceParam * 1.2f;
+        oscGain = resonanceParam > 0.75f ? (resonanceParam - 0.75f) * 4.0f : ZERO;
+        oscStep = oscGain > ZERO ? oscIncrement : ZERO;
+        oscBlend = ONE - oscGain * 0.3f;
+        // Halved when the cutoff is above a quarter of the sample rate.
+        oscLevel = oscGain * 0.15f * (oscIncrement > HALF * FastMath::PI ? HALF : ONE);
+        finalGain = 1.1f + resonanceParam * 0.3f;
     }
 
     [[nodiscard]] inline float calculateResonance(float param) const noexcept {
@@ -125,13 +146,38 @@ private:
         return param * param * 6.0f + param * 1.5f;
     }
 
-    [[nodiscard]] inline float saturate(float x) const noexcept {
-        x = std::clamp(x, -4.f, 4.f);
-        if (x > ZERO) {
-            return x / (ONE + x * 0.4f);
-        } else {
-            return x / (ONE + std::abs(x) * HALF);
-        }
+    [[nodiscard]] T stepEuler(T x) noexcept {
+        T hp = saturate(x - resonance * s2 - s1);
+        
+        s1 += f * saturate(hp);
+        s2 += f * saturate(s1);
+        return s2;
+    }
+
+    // Same loop with trapezoidal integrators: hp = x - sat(bp) - resonance * lp, bp = g hp + s1,
+    // lp = g bp + s2. Solved for bp with one Newton step from the previous sample's bp.
+    [[nodiscard]] T stepZdf(T x) noexcept {
+        const float linear = ONE + resonance * g * g;
+        const T target = g * (x - resonance * s2) + s1;
+        T bp = bandpass;
+        const T magnitude = vector_ops::abs(bp);
+        const T knee = ONE + vector_ops::select(bp > ZERO, T(0.4f), T(HALF)) * magnitude;
+        const T slope = vector_ops::select(magnitude < 4.f, ONE / (knee * knee), T(ZERO));
+        bp -= (bp * linear + g * saturate(bp) - target) / (linear + g * slope);
+        bandpass = bp;
+
+        T lp = g * bp + s2;
+        s1 = TWO * bp - s1;
+        s2 = TWO * lp - s2;
+        return lp;
+    }
+
+    // x / (1 + 0.4 x) above zero, x / (1 + 0.5 |x|) below.
+    [[nodiscard]] static inline T saturate(T x) noexcept {
+        x = vector_ops::clamp(x, T(-4.f), T(4.f));
+        return x / (ONE + vector_ops::select(x > ZERO, x * 0.4f, -x * HALF));
     }    
 };
+
+using MS20Filter = TMS20Filter<>;
 }
\ No newline at end of file
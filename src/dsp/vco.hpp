@@ -15,30 +15,16 @@ public:
 
     constexpr VCO() noexcept = default;
 
-    void initialize() noexcept {
-        antiAlias.setCutoff(8000.0f / 48000.0f);
-        setWaveform(currentWaveform);
-    }
-
-    void setWaveform(Waveform waveform) noexcept {
-        if (currentWaveform != waveform) {
-            currentWaveform = waveform;
-            switch (waveform) {
-                case Waveform::TRIANGLE: 
-                    processFunction = &VCO::processTriangle; 
-                    break;
-                case Waveform::SAW: 
-                    processFunction = &VCO::processSaw; 
-                    break;
-                case Waveform::SQUARE: 
-                default: 
-                    processFunction = &VCO::processSquare; 
-            }
-        }
-    }
-
+    // The waveform is a template argument: each voice kernel is compiled for one waveform.
+    template<Waveform W>
     [[nodiscard]] float process(float sampleTime) noexcept {
-        return (this->*processFunction)(sampleTime);
+        if constexpr (W == Waveform::TRIANGLE) {
+            return processTriangle(sampleTime);
+        } else if constexpr (W == Waveform::SAW) {
+            return processSaw(sampleTime);
+        } else {
+            return processSquare(sampleTime);
+        }
     }
 
     void setPitch(float pitch) noexcept {
@@ -65,11 +51,6 @@ private:
     float lastSaw{ZERO};
     float lastPulse{ZERO};
     bool active{true};
-    
-    Waveform currentWaveform{Waveform::SAW};
-    float (VCO::*processFunction)(float){&VCO::processSaw};
-
-    rack::dsp::RCFilter antiAlias{};
 
     [[nodiscard]] static constexpr float polyBLEP(float t, float dt) noexcept {
         if (t < dt) {
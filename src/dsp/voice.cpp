@@ -0,0 +1,67 @@
+#include "../clonotribe.hpp"
+#include <array>
+#include <utility>
+
+// One gain per oversampled sample. The envelope's segment times come from Envelope::setType(),
+// applied at control rate.
+template<Envelope::Type E>
+void Clonotribe::processEnvelope(Envelope& envelope, float finalSequencerGate, float* gains, int frames) {
+    if constexpr (E == Envelope::Type::GATE) {
+        std::fill(gains, gains + frames, (finalSequencerGate > ONE) ? ONE : ZERO);
+    } else {
+        envelope.process(gains, frames);
+    }
+}
+
+// LFO routing, envelope, VCO -> VCF -> VCA -> distortion at the selected oversampling factor.
+template<VCO::Waveform W, FilterType F, Envelope::Type E, LFO::Target T>
+float Clonotribe::processVoice(const VoiceFrame& frame) {
+    float lfoToVCO = (T == LFO::Target::VCF) ? ZERO : frame.lfo * HALF;
+    float lfoToVCF = (T == LFO::Target::VCO) ? ZERO : frame.lfo;
+
+    vco.setPitch(frame.pitch + lfoToVCO);
+    filterProcessor.update(std::clamp(frame.cutoff + lfoToVCF, ZERO, ONE), frame.resonance);
+
+    const int factor = oversampler.getFactor();
+    std::array<float, Oversampler::MAX_FACTOR> envelopeGains;
+    processEnvelope<E>(envelope, frame.gate, envelopeGains.data(), factor);
+    float voiceSampleTime = frame.sampleTime / static_cast<float>(factor);
+    size_t index = 0;
+    return oversampler.process(frame.external, [&](float external) {
+        float vcoOutput = dcBlockerPost.process(vco.process<W>(voiceSampleTime));
+        float filteredSignal = dcBlockerPostFilter.process(filterProcessor.processSample<F>(vcoOutput + external));
+        return processDistortion(filteredSignal * frame.gain * envelopeGains[index++], frame.distortion);
+    });
+}
+
+namespace {
+constexpr size_t VARIANTS = 3;
+
+template<size_t I>
+constexpr Clonotribe::VoiceKernel voiceKernelAt() {
+    return &Clonotribe::processVoice<
+        static_cast<VCO::Waveform>(I / (VARIANTS * VARIANTS * VARIANTS)),
+        static_cast<FilterType>(I / (VARIANTS * VARIANTS) % VARIANTS),
+        static_cast<Envelope::Type>(I / VARIANTS % VARIANTS),
+        static_cast<LFO::Target>(I % VARIANTS)>;
+}
+
+template<size_t... I>
+constexpr std::array<Clonotribe::VoiceKernel, sizeof...(I)> makeVoiceKernels(std::index_sequence<I...>) {
+    return {voiceKernelAt<I>()...};
+}
+
+constexpr auto VOICE_KERNELS = makeVoiceKernels(std::make_index_sequence<VARIANTS * VARIANTS * VARIANTS * VARIANTS>());
+
+size_t variant(int value) {
+    return static_cast<size_t>(std::clamp(value, 0, static_cast<int>(VARIANTS) - 1));
+}
+}
+
+void Clonotribe::selectVoiceKernel(VCO::Waveform waveform, FilterType filterType, Envelope::Type envelopeType, LFO::Target lfoTarget) {
+    size_t index = variant(static_cast<int>(waveform));
+    index = index * VARIANTS + variant(static_cast<int>(filterType));
+    index = index * VARIANTS + variant(static_cast<int>(envelopeType));
+    index = index * VARIANTS + variant(static_cast<int>(lfoTarget));
+    voiceKernel = VOICE_KERNELS[index];
+}
@@ -1,8 +1,10 @@
 #include "plugin.hpp"
+#include "dsp/kernels.hpp"
 
 rack::plugin::Plugin* pluginInstance;
 
 void init(rack::plugin::Plugin* p) {
     pluginInstance = p;
+    clonotribe::Kernels::select(clonotribe::Kernels::detect());
     p->addModel(modelClonotribe);
 }
@@ -9,6 +9,19 @@ using namespace rack::window;
 using namespace rack::engine;
 using namespace rack::ui;
 
+struct PatternEditAction : history::ModuleAction {
+    explicit PatternEditAction(int64_t id) {
+        name = "edit Clonotribe pattern";
+        moduleId = id;
+    }
+    void undo() override {
+        if (auto* m = dynamic_cast<Clonotribe*>(APP->engine->getModule(moduleId))) m->undoPatternEdit();
+    }
+    void redo() override {
+        if (auto* m = dynamic_cast<Clonotribe*>(APP->engine->getModule(moduleId))) m->redoPatternEdit();
+    }
+};
+
 struct MainPanel : ModuleWidget {
     ParamWidget* tempoKnob = nullptr;
     ParamWidget* lfoRateKnob = nullptr;
@@ -157,6 +170,11 @@ struct MainPanel : ModuleWidget {
 
     void step() override {
         hideParamsForConnectedInputs();
+        if (auto* clonotribeModule = dynamic_cast<Clonotribe*>(module)) {
+            if (clonotribeModule->updatePatternHistory()) {
+                APP->history->push(new PatternEditAction(clonotribeModule->id));
+            }
+        }
         ModuleWidget::step();
     }
 
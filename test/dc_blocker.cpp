@@ -0,0 +1,85 @@
+#include "doctest.h"
+#include "../src/dsp/dc_blocker.hpp"
+#include <algorithm>
+#include <cmath>
+
+using clonotribe::DcBlocker;
+using clonotribe::FastMath;
+
+namespace {
+// The serial processFinal chain as it was before the stages were fused.
+struct SerialFinalBlocker {
+    float R1, R2, R3;
+    float x1 = ZERO, x2 = ZERO, x3 = ZERO;
+    float y1 = ZERO, y2 = ZERO, y3 = ZERO;
+    float dcEstimate = ZERO;
+
+    SerialFinalBlocker(float sampleRate, float cutoff) {
+        const float w1 = FastMath::TWO_PI * cutoff / sampleRate;
+        R1 = std::clamp((ONE - w1) / (ONE + w1), 0.9f, 0.998f);
+        const float w2 = FastMath::TWO_PI * (cutoff * HALF) / sampleRate;
+        R2 = std::clamp((ONE - w2) / (ONE + w2), 0.95f, 0.999f);
+        const float w3 = FastMath::TWO_PI * (cutoff * 0.25f) / sampleRate;
+        R3 = std::clamp((ONE - w3) / (ONE + w3), 0.98f, 0.9999f);
+    }
+
+    float process(float x) {
+        x = std::clamp(x, -100.0f, 100.0f);
+        y1 = x - x1 + R1 * y1;
+        x1 = x;
+        y2 = y1 - x2 + R2 * y2;
+        x2 = y1;
+        dcEstimate = dcEstimate * (ONE - 0.0001f) + y2 * 0.0001f;
+        float x3in = y2 - dcEstimate;
+        y3 = x3in - x3 + R3 * y3;
+        x3 = x3in;
+        return y3;
+    }
+};
+
+template<typename Process>
+float gainAt(Process process, float frequency, float sampleRate) {
+    const int settle = static_cast<int>(sampleRate * 5.0f);
+    const int measure = static_cast<int>(sampleRate * 2.0f);
+    double inEnergy = 0.0;
+    double outEnergy = 0.0;
+    for (int i = 0; i < settle + measure; ++i) {
+        float x = static_cast<float>(std::sin(2.0 * M_PI * frequency * i / sampleRate));
+        float y = process(x);
+        if (i >= settle) {
+            inEnergy += static_cast<double>(x) * x;
+            outEnergy += static_cast<double>(y) * y;
+        }
+    }
+    return static_cast<float>(std::sqrt(outEnergy / inEnergy));
+}
+}
+
+TEST_CASE("Fused DcBlocker keeps the serial frequency response") {
+    for (float sampleRate : {44100.0f, 48000.0f, 96000.0f}) {
+        for (float frequency : {0.5f, 2.0f, 5.0f, 10.0f, 20.0f, 50.0f, 200.0f, 1000.0f, 10000.0f}) {
+            DcBlocker fused;
+            fused.setSampleRate(sampleRate);
+            fused.setCutoff(10.0f);
+            SerialFinalBlocker serial(sampleRate, 10.0f);
+            float expected = gainAt([&](float x) { return serial.process(x); }, frequency, sampleRate);
+            float actual = gainAt([&](float x) { return fused.processFinal(x); }, frequency, sampleRate);
+            CAPTURE(sampleRate);
+            CAPTURE(frequency);
+            CHECK(std::abs(20.0f * std::log10(actual / expected)) < 0.01f);
+        }
+    }
+}
+
+TEST_CASE("Fused DcBlocker matches the serial chain sample by sample") {
+    DcBlocker fused;
+    fused.setSampleRate(48000.0f);
+    fused.setCutoff(10.0f);
+    SerialFinalBlocker serial(48000.0f, 10.0f);
+    float maxError = ZERO;
+    for (int i = 0; i < 48000; ++i) {
+        float x = 2.0f + std::sin(0.01f * static_cast<float>(i)) + 0.5f * std::sin(0.37f * static_cast<float>(i));
+        maxError = std::max(maxError, std::abs(fused.processFinal(x) - serial.process(x)));
+    }
+    CHECK(maxError < 1e-3f);
+}
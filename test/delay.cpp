@@ -0,0 +1,215 @@
+#include "doctest.h"
+#include "../src/dsp/delay.hpp"
+#include <chrono>
+#include <cmath>
+
+using clonotribe::Delay;
+using clonotribe::FastMath;
+using clonotribe::float_4;
+
+namespace {
+constexpr float TIME_FOR_100MS = (0.1f - MIN) / 1.99f;
+
+// Stands in for the module's worker: the first wet sample asks for the line it needs.
+void prepare(Delay& delay) {
+    (void)delay.processStereo(ZERO, ZERO, ZERO, ONE);
+    delay.allocate();
+}
+
+int echoPosition(Delay& delay, float sampleRate, float time = TIME_FOR_100MS) {
+    delay.setSampleRate(sampleRate);
+    prepare(delay);
+    // Long enough for the smoothed time to settle and for echoes recorded at the old rate to die out.
+    for (int i = 0; i < static_cast<int>(sampleRate * HALF); ++i) {
+        (void)delay.process(ZERO, ZERO, time, ONE);
+    }
+    (void)delay.process(ONE, ZERO, time, ONE);
+    int peakIndex = 0;
+    float peak = ZERO;
+    for (int i = 1; i < static_cast<int>(sampleRate * 0.2f) + static_cast<int>(sampleRate * time * 10.0f); ++i) {
+        float out = std::abs(delay.process(ZERO, ZERO, time, ONE));
+        if (out > peak) {
+            peak = out;
+            peakIndex = i;
+        }
+    }
+    return peakIndex;
+}
+}
+
+TEST_CASE("Delay echo follows sample rate changes while running") {
+    Delay delay;
+    for (float sampleRate : {44100.0f, 96000.0f, 192000.0f, 48000.0f, 384000.0f}) {
+        int expected = static_cast<int>(std::min(0.1f * sampleRate, static_cast<float>(Delay::lineSize(Delay::MAX_DELAY_TIME))));
+        CHECK(std::abs(echoPosition(delay, sampleRate) - expected) <= 2);
+    }
+}
+
+TEST_CASE("Delay stays bounded when sample rate changes mid-stream") {
+    Delay delay;
+    prepare(delay);
+    const float rates[] = {44100.0f, 192000.0f, 22050.0f, 768000.0f};
+    float phase = ZERO;
+    bool finite = true;
+    float maxOut = ZERO;
+    for (int block = 0; block < 400; ++block) {
+        delay.setSampleRate(rates[block % 4]);
+        for (int i = 0; i < 64; ++i) {
+            phase += 0.05f;
+            float out = delay.process(5.0f * std::sin(phase), ZERO, ONE, ONE);
+            finite = finite && std::isfinite(out);
+            maxOut = std::max(maxOut, std::abs(out));
+        }
+    }
+    CHECK(finite);
+    CHECK(maxOut < 20.0f);
+}
+
+TEST_CASE("Delay grows its line for long mode") {
+    Delay delay;
+    delay.setLongMode(true);
+    constexpr float time = (6.0f - MIN) / (Delay::LONG_DELAY_TIME - MIN);
+    CHECK(std::abs(echoPosition(delay, 48000.0f, time) - 6 * 48000) <= 2);
+}
+
+TEST_CASE("Delay allocates nothing until it is used") {
+    Delay delay;
+    for (int i = 0; i < 100; ++i) CHECK(delay.processStereo(HALF, ZERO, HALF, ZERO)[0] == HALF);
+    delay.allocate();
+    CHECK_FALSE(delay.hasLine());
+
+    // The first wet sample passes through dry and asks for the line.
+    CHECK(delay.process(HALF, ZERO, HALF, HALF) == HALF);
+    CHECK_FALSE(delay.hasLine());
+    delay.allocate();
+    CHECK(delay.hasLine());
+}
+
+TEST_CASE("Delay keeps replaced lines until process() has moved on") {
+    Delay delay;
+    prepare(delay);
+    (void)delay.process(ZERO, ZERO, ZERO, ONE);
+
+    // The stereo line replaces the mono one the audio thread last read.
+    delay.setStereo(Delay::Stereo::PING_PONG);
+    (void)delay.processStereo(ZERO, ZERO, ZERO, ONE);
+    delay.allocate();
+    CHECK(delay.retainedLines() == 1);
+    (void)delay.processStereo(ZERO, ZERO, ZERO, ONE);
+    delay.allocate();
+    CHECK(delay.retainedLines() == 0);
+
+    // Switching to long mode drops the short line once process() has let go of it.
+    delay.setLongMode(true);
+    delay.allocate();
+    CHECK(delay.retainedLines() == 1);
+    (void)delay.processStereo(ZERO, ZERO, ZERO, ONE);
+    delay.allocate();
+    CHECK(delay.retainedLines() == 0);
+    CHECK(delay.hasLine());
+}
+
+TEST_CASE("Delay keeps float precision on the short line and 16 bits on the long line") {
+    for (bool longMode : {false, true}) {
+        CAPTURE(longMode);
+        Delay delay;
+        delay.setLongMode(longMode);
+        const float time = (0.1f - MIN) / ((longMode ? Delay::LONG_DELAY_TIME : Delay::MAX_DELAY_TIME) - MIN);
+        // An impulse well below the 16-bit step of about 0.4 mV.
+        constexpr float impulse = 1e-5f;
+        echoPosition(delay, 48000.0f, time);
+        delay.clear();
+        (void)delay.process(impulse, ZERO, time, ONE);
+        float echo = ZERO;
+        for (int i = 0; i < 6000; ++i) echo = std::max(echo, std::abs(delay.process(ZERO, ZERO, time, ONE)));
+        if (longMode) {
+            CHECK(echo == ZERO);
+        } else {
+            CHECK(echo == doctest::Approx(impulse).epsilon(0.05));
+        }
+    }
+}
+
+TEST_CASE("Delay applies mode changes on the audio thread") {
+    Delay delay;
+    delay.setMode(Delay::Mode::DIGITAL);
+    delay.setStereo(Delay::Stereo::SPREAD);
+    delay.setLongMode(true);
+    CHECK(delay.getMode() == Delay::Mode::DIGITAL);
+    CHECK(delay.getStereo() == Delay::Stereo::SPREAD);
+    CHECK(delay.isLongMode());
+    // Nothing is allocated by the setters themselves.
+    delay.allocate();
+    CHECK_FALSE(delay.hasLine());
+}
+
+TEST_CASE("Delay digital mode changes time without pitch bend") {
+    constexpr float sampleRate = 48000.0f;
+    constexpr float omega = FastMath::TWO_PI * 1000.0f / sampleRate;
+    constexpr float time = (0.2f - MIN) / 1.99f;
+    for (Delay::Mode mode : {Delay::Mode::TAPE, Delay::Mode::DIGITAL}) {
+        Delay delay;
+        delay.setSampleRate(sampleRate);
+        delay.setMode(mode);
+        prepare(delay);
+        int n = 0;
+        for (; n < 24000; ++n) {
+            (void)delay.process(std::sin(omega * static_cast<float>(n)), ZERO, TIME_FOR_100MS, HALF);
+        }
+        // A 1 kHz tone crosses zero three times per 1.5 ms whatever the delay, unless the read head glides.
+        int crossings = 0;
+        float previous = ZERO;
+        for (int i = 0; i < 1500; ++i, ++n) {
+            float out = delay.process(std::sin(omega * static_cast<float>(n)), ZERO, time, HALF);
+            if (i > 0 && (out > ZERO) != (previous > ZERO)) crossings++;
+            previous = out;
+        }
+        if (mode == Delay::Mode::DIGITAL) {
+            CHECK(std::abs(crossings - 62) <= 2);
+        } else {
+            CHECK(std::abs(crossings - 62) > 2);
+        }
+    }
+}
+
+TEST_CASE("Delay ping-pong alternates echoes between sides") {
+    Delay delay;
+    delay.setSampleRate(48000.0f);
+    delay.setStereo(Delay::Stereo::PING_PONG);
+    prepare(delay);
+    for (int i = 0; i < 24000; ++i) {
+        (void)delay.processStereo(ZERO, ZERO, TIME_FOR_100MS, ONE);
+    }
+    (void)delay.processStereo(ONE, ZERO, TIME_FOR_100MS, ONE);
+    float left[3] = {};
+    float right[3] = {};
+    for (int i = 1; i < 3 * 4800 + 2400; ++i) {
+        float_4 out = delay.processStereo(ZERO, ZERO, TIME_FOR_100MS, ONE);
+        int echo = (i + 2400) / 4800 - 1;
+        left[echo] = std::max(left[echo], std::abs(out[0]));
+        right[echo] = std::max(right[echo], std::abs(out[1]));
+    }
+    CHECK(left[0] > 0.5f);
+    CHECK(right[0] < MIN);
+    CHECK(right[1] > 0.1f);
+    CHECK(left[1] < MIN);
+    CHECK(left[2] > MIN);
+}
+
+TEST_CASE("Delay inner loop benchmark") {
+    constexpr int SAMPLES = 1 << 21;
+    for (Delay::Stereo stereo : {Delay::Stereo::MONO, Delay::Stereo::PING_PONG}) {
+        Delay delay;
+        delay.setSampleRate(48000.0f);
+        delay.setStereo(stereo);
+        prepare(delay);
+        float sum = ZERO;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < SAMPLES; ++i) {
+            sum += delay.processStereo((i & 255) < 128 ? ONE : -ONE, ZERO, HALF, HALF)[0];
+        }
+        auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        MESSAGE((stereo == Delay::Stereo::MONO ? "Delay mono: " : "Delay stereo: ") << elapsed / SAMPLES << " ns/sample");
+        CHECK(std::isfinite(sum));
+    }
+}
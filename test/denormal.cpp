@@ -0,0 +1,98 @@
+#include "doctest.h"
+#include "../src/dsp/denormal.hpp"
+#include "../src/dsp/dc_blocker.hpp"
+#include "../src/dsp/vcf/ms20.hpp"
+#include "../src/dsp/vcf/ladder.hpp"
+#include "../src/dsp/vcf/moog.hpp"
+#include <chrono>
+#include <cmath>
+#include <string>
+
+using clonotribe::DcBlocker;
+using clonotribe::DenormalGuard;
+using clonotribe::LadderFilter;
+using clonotribe::MoogFilter;
+using clonotribe::MS20Filter;
+
+namespace {
+constexpr int DECAY_SAMPLES = 1 << 18;
+
+struct DecayResult {
+    double earlyNs;
+    double lateNs;
+    float last;
+};
+
+// Excites the filter once, then times the start and the tail of its decay to silence.
+template<typename Process>
+DecayResult measureDecay(Process process) {
+    for (int i = 0; i < 64; ++i) (void)process(ONE);
+    using Clock = std::chrono::steady_clock;
+    constexpr int quarter = DECAY_SAMPLES / 4;
+    float sink = ZERO;
+    auto start = Clock::now();
+    for (int i = 0; i < quarter; ++i) sink += process(ZERO);
+    auto early = Clock::now();
+    for (int i = quarter; i < DECAY_SAMPLES - quarter; ++i) sink += process(ZERO);
+    auto late = Clock::now();
+    float last = ZERO;
+    for (int i = DECAY_SAMPLES - quarter; i < DECAY_SAMPLES; ++i) last = process(ZERO);
+    auto end = Clock::now();
+    CHECK(std::isfinite(sink));
+    return {
+        std::chrono::duration<double, std::nano>(early - start).count() / quarter,
+        std::chrono::duration<double, std::nano>(end - late).count() / quarter,
+        last
+    };
+}
+
+template<typename Filter>
+Filter makeFilter(float cutoff, float resonance) {
+    Filter filter;
+    filter.setSampleRate(48000.0f);
+    filter.setCutoff(cutoff);
+    filter.setResonance(resonance);
+    return filter;
+}
+
+template<typename Filter>
+void checkFilterDecay(const std::string& name) {
+    Filter guarded = makeFilter<Filter>(0.45f, 0.3f);
+    Filter unguarded = makeFilter<Filter>(0.45f, 0.3f);
+    DecayResult without = measureDecay([&](float x) { return unguarded.process(x); });
+    DenormalGuard guard;
+    DecayResult with = measureDecay([&](float x) { return guarded.process(x); });
+    MESSAGE(name << " decay ns/sample early/late: guarded " << with.earlyNs << "/" << with.lateNs
+        << ", unguarded " << without.earlyNs << "/" << without.lateNs);
+    // Flushed state may settle just above FLT_MIN, but never in the slow subnormal range.
+    CHECK(std::abs(with.last) < 1e-30f);
+    if (DenormalGuard::isActive()) CHECK(std::fpclassify(with.last) != FP_SUBNORMAL);
+}
+}
+
+TEST_CASE("DenormalGuard restores the previous state") {
+    bool before = DenormalGuard::isActive();
+    {
+        DenormalGuard guard;
+        CHECK(DenormalGuard::isActive());
+    }
+    CHECK(DenormalGuard::isActive() == before);
+}
+
+TEST_CASE("Denormal stress benchmark on long decays") {
+    checkFilterDecay<MS20Filter>("MS20");
+    checkFilterDecay<LadderFilter>("Ladder");
+    checkFilterDecay<MoogFilter>("Moog");
+
+    DcBlocker unguarded;
+    unguarded.setSampleRate(48000.0f);
+    unguarded.setCutoff(10.0f);
+    DecayResult without = measureDecay([&](float x) { return unguarded.processFinal(x); });
+    DenormalGuard guard;
+    DcBlocker guarded;
+    guarded.setSampleRate(48000.0f);
+    guarded.setCutoff(10.0f);
+    DecayResult with = measureDecay([&](float x) { return guarded.processFinal(x); });
+    MESSAGE("DcBlocker decay ns/sample early/late: guarded " << with.earlyNs << "/" << with.lateNs
+        << ", unguarded " << without.earlyNs << "/" << without.lateNs);
+}
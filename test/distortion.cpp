@@ -0,0 +1,79 @@
+#include "doctest.h"
+#include "../src/dsp/distortion.hpp"
+#include <cmath>
+#include <vector>
+
+using clonotribe::Distortion;
+using clonotribe::FastMath;
+
+namespace {
+constexpr int N = 4096;
+constexpr int FUNDAMENTAL_BIN = 373;
+
+// Ratio of energy in inharmonic bins (aliases folded back from above Nyquist) to energy in harmonic bins.
+double aliasRatio(Distortion::Algorithm algorithm, float amount) {
+    Distortion distortion;
+    distortion.setAlgorithm(algorithm);
+    std::vector<double> signal(N);
+    const double omega = 2.0 * M_PI * FUNDAMENTAL_BIN / N;
+    for (int i = -N; i < N; ++i) {
+        float out = distortion.process(static_cast<float>(std::sin(omega * i)), amount);
+        if (i >= 0) signal[static_cast<size_t>(i)] = out;
+    }
+    double harmonic = 0.0;
+    double alias = 0.0;
+    for (int k = 1; k < N / 2; ++k) {
+        double re = 0.0;
+        double im = 0.0;
+        for (int n = 0; n < N; ++n) {
+            double phase = 2.0 * M_PI * static_cast<double>((static_cast<long>(k) * n) % N) / N;
+            re += signal[static_cast<size_t>(n)] * std::cos(phase);
+            im -= signal[static_cast<size_t>(n)] * std::sin(phase);
+        }
+        double power = re * re + im * im;
+        if (k % FUNDAMENTAL_BIN == 0) {
+            harmonic += power;
+        } else {
+            alias += power;
+        }
+    }
+    return alias / harmonic;
+}
+}
+
+TEST_CASE("Distortion ADAA matches the classic shaper at low frequencies") {
+    Distortion classic;
+    Distortion adaa;
+    adaa.setAlgorithm(Distortion::Algorithm::ADAA);
+    float maxError = ZERO;
+    // First-order ADAA delays by half a sample, so the reference is fed half a sample later.
+    for (int i = 0; i < 48000; ++i) {
+        float t = static_cast<float>(i) / 48000.0f;
+        float x = 0.3f * std::sin(FastMath::TWO_PI * 20.0f * t);
+        float xHalf = 0.3f * std::sin(FastMath::TWO_PI * 20.0f * (t - HALF / 48000.0f));
+        float error = std::abs(classic.process(xHalf, 0.7f) - adaa.process(x, 0.7f));
+        // The first ADAA sample has no previous input to average over.
+        if (i > 0) maxError = std::max(maxError, error);
+    }
+    CHECK(maxError < 0.02f);
+}
+
+TEST_CASE("Distortion ADAA reduces aliasing") {
+    for (float amount : {0.3f, 0.8f}) {
+        double classic = aliasRatio(Distortion::Algorithm::CLASSIC, amount);
+        double adaa = aliasRatio(Distortion::Algorithm::ADAA, amount);
+        MESSAGE("amount " << amount << ": alias/harmonic classic " << 10.0 * std::log10(classic) << " dB, ADAA " << 10.0 * std::log10(adaa) << " dB");
+        CHECK(adaa < classic * 0.5);
+    }
+}
+
+TEST_CASE("Distortion shaper table matches the direct shaper") {
+    clonotribe::SharedTable<Distortion::ShaperTable> table;
+    float maxError = 0.0f;
+    for (float amount : {0.05f, 0.3f, 0.5f, 0.77f, 1.0f}) {
+        for (float u = -4.0f; u <= 4.0f; u += 0.0013f) {
+            maxError = std::max(maxError, std::abs(table->lookup(u, amount) - Distortion::shape(u, amount)));
+        }
+    }
+    CHECK(maxError < 1e-3f);
+}
@@ -0,0 +1,66 @@
+#include "doctest.h"
+#include "../src/dsp/sequencer/drum_pattern.hpp"
+
+using clonotribe::DrumPattern;
+
+namespace {
+// The "drumPatterns" array of an old patch: kick, snare, hi-hat, eight booleans each.
+constexpr std::array<std::array<bool, DrumPattern::LEGACY_STEPS>, DrumPattern::LANES> LEGACY_PATCH = {{
+    {true, false, false, false, true, false, false, false},
+    {false, false, true, false, false, false, true, false},
+    {true, true, true, true, true, true, true, true}
+}};
+}
+
+TEST_CASE("DrumPattern lanes are bit masks") {
+    DrumPattern pattern;
+    pattern.set(0, 0, true);
+    pattern.set(0, 15, true);
+    pattern.set(2, 3, true);
+    CHECK(pattern.hits[0] == ((1ull << 0) | (1ull << 15)));
+    CHECK(pattern.hits[1] == 0);
+    CHECK(pattern.hits[2] == (1ull << 3));
+    CHECK(pattern.lanesAt(0) == 1u);
+    CHECK(pattern.lanesAt(3) == 4u);
+
+    pattern.toggle(0, 15);
+    CHECK_FALSE(pattern.isSet(0, 15));
+    CHECK_FALSE(pattern.isSet(5, 0));
+    CHECK_FALSE(pattern.isSet(0, DrumPattern::MAX_STEPS));
+
+    pattern.fillLane(1, 8);
+    CHECK(pattern.hits[1] == 0xFFull);
+}
+
+TEST_CASE("DrumPattern accents live on hits") {
+    DrumPattern pattern;
+    pattern.toggleAccent(1, 6);
+    CHECK(pattern.isSet(1, 6));
+    CHECK(pattern.isAccent(1, 6));
+    CHECK(pattern.accents[1] == (1ull << 6));
+    CHECK(pattern.accentsAt(6) == 2u);
+
+    // Clearing the hit clears its accent; toggling the accent off keeps the hit.
+    pattern.set(1, 6, false);
+    CHECK(pattern.accents[1] == 0);
+    pattern.toggleAccent(1, 6);
+    pattern.toggleAccent(1, 6);
+    CHECK(pattern.isSet(1, 6));
+    CHECK_FALSE(pattern.isAccent(1, 6));
+}
+
+TEST_CASE("Old drumPatterns load into eight-step masks") {
+    DrumPattern pattern = DrumPattern::fromLegacy(LEGACY_PATCH, false);
+    CHECK(pattern.hits[0] == 0b00010001ull);
+    CHECK(pattern.hits[1] == 0b01000100ull);
+    CHECK(pattern.hits[2] == 0b11111111ull);
+    for (uint64_t accents : pattern.accents) CHECK(accents == 0);
+}
+
+TEST_CASE("Old drumPatterns load onto the even steps in sixteen-step mode") {
+    DrumPattern pattern = DrumPattern::fromLegacy(LEGACY_PATCH, true);
+    CHECK(pattern.hits[0] == ((1ull << 0) | (1ull << 8)));
+    CHECK(pattern.hits[1] == ((1ull << 4) | (1ull << 12)));
+    CHECK(pattern.hits[2] == 0x5555ull);
+    for (uint64_t accents : pattern.accents) CHECK(accents == 0);
+}
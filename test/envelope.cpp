@@ -0,0 +1,85 @@
+#include "doctest.h"
+#include "../src/dsp/envelope.hpp"
+#include <cmath>
+#include <vector>
+
+using clonotribe::Envelope;
+
+namespace {
+// Samples until the envelope leaves `stage`.
+int stageLength(Envelope& envelope, Envelope::Stage stage) {
+    int samples = 0;
+    while (envelope.stage == stage && samples < 10000000) {
+        (void)envelope.process();
+        ++samples;
+    }
+    return samples;
+}
+}
+
+TEST_CASE("Envelope segments take their set times at every sample rate") {
+    for (float sampleRate : {44100.0f, 96000.0f, 192000.0f}) {
+        CAPTURE(sampleRate);
+        Envelope envelope;
+        envelope.setSampleRate(sampleRate);
+        envelope.setType(Envelope::Type::DECAY);
+        envelope.trigger();
+        CHECK(static_cast<float>(stageLength(envelope, Envelope::Stage::ATTACK)) / sampleRate == doctest::Approx(0.001f).epsilon(0.05));
+        CHECK(static_cast<float>(stageLength(envelope, Envelope::Stage::DECAY)) / sampleRate == doctest::Approx(HALF).epsilon(0.01));
+        CHECK(envelope.value == ZERO);
+
+        envelope.setType(Envelope::Type::ATTACK);
+        envelope.trigger();
+        CHECK(static_cast<float>(stageLength(envelope, Envelope::Stage::ATTACK)) / sampleRate == doctest::Approx(0.1f).epsilon(0.01));
+        (void)envelope.process();
+        CHECK(envelope.stage == Envelope::Stage::SUSTAIN);
+        CHECK(envelope.value == ONE);
+        envelope.gateOff();
+        CHECK(static_cast<float>(stageLength(envelope, Envelope::Stage::RELEASE)) / sampleRate == doctest::Approx(0.1f).epsilon(0.01));
+        CHECK(envelope.stage == Envelope::Stage::OFF);
+    }
+}
+
+TEST_CASE("Envelope decay is exponential") {
+    Envelope envelope;
+    envelope.setSampleRate(48000.0f);
+    envelope.setType(Envelope::Type::DECAY);
+    envelope.trigger();
+    (void)stageLength(envelope, Envelope::Stage::ATTACK);
+    // Equal times take off equal fractions of the remaining distance to the target.
+    std::vector<float> levels;
+    for (int block = 0; block < 4; ++block) {
+        levels.push_back(envelope.value + 0.01f);
+        for (int i = 0; i < 4800; ++i) (void)envelope.process();
+    }
+    const float ratio = levels[1] / levels[0];
+    CHECK(ratio < 0.8f);
+    CHECK(levels[2] / levels[1] == doctest::Approx(ratio).epsilon(1e-3));
+    CHECK(levels[3] / levels[2] == doctest::Approx(ratio).epsilon(1e-3));
+}
+
+TEST_CASE("Envelope block rendering matches per-sample rendering") {
+    Envelope single;
+    Envelope block;
+    for (Envelope* envelope : {&single, &block}) {
+        envelope->setSampleRate(88200.0f);
+        envelope->setType(Envelope::Type::ATTACK);
+        envelope->trigger();
+    }
+    std::vector<float> expected;
+    std::vector<float> actual;
+    for (int frame = 0; frame < 12000; ++frame) {
+        if (frame == 6000) {
+            single.gateOff();
+            block.gateOff();
+        }
+        float gains[4];
+        block.process(gains, 4);
+        for (float gain : gains) {
+            actual.push_back(gain);
+            expected.push_back(single.process());
+        }
+    }
+    CHECK(actual == expected);
+    CHECK(block.stage == single.stage);
+}
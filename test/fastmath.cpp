@@ -0,0 +1,123 @@
+#include "doctest.h"
+#include "../src/dsp/fastmath.hpp"
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+using clonotribe::FastMath;
+using clonotribe::float_4;
+#if defined(__AVX2__)
+using clonotribe::float_8;
+#endif
+
+namespace {
+float lane(float x, int) { return x; }
+float lane(const float_4& x, int i) { return x[i]; }
+#if defined(__AVX2__)
+float lane(const float_8& x, int i) {
+    alignas(32) float values[8];
+    x.store(values);
+    return values[i];
+}
+#endif
+
+template<typename T>
+constexpr int width() {
+    if constexpr (std::is_same_v<T, float>) return 1;
+    else return static_cast<int>(sizeof(T) / sizeof(float));
+}
+
+template<typename T>
+T gather(const float* values) {
+    if constexpr (std::is_same_v<T, float>) return values[0];
+    else return T::load(values);
+}
+
+// Largest error of fn against reference over [lo, hi]; relative errors are taken against max(|ref|, 1).
+template<typename T, typename Fn, typename Ref>
+double maxError(Fn fn, Ref ref, float lo, float hi, bool relative = false) {
+    constexpr int W = width<T>();
+    constexpr int COUNT = 1 << 16;
+    double worst = 0.0;
+    std::array<float, W> x{};
+    for (int i = 0; i < COUNT; i += W) {
+        for (int l = 0; l < W; ++l) {
+            x[static_cast<size_t>(l)] = lo + (hi - lo) * static_cast<float>(i + l) / static_cast<float>(COUNT - 1);
+        }
+        T y = fn(gather<T>(x.data()));
+        for (int l = 0; l < W; ++l) {
+            double expected = ref(static_cast<double>(x[static_cast<size_t>(l)]));
+            double error = std::abs(static_cast<double>(lane(y, l)) - expected);
+            if (relative) error /= std::max(std::abs(expected), 1e-30);
+            worst = std::max(worst, error);
+        }
+    }
+    return worst;
+}
+
+template<typename T>
+void checkAccuracy() {
+    CHECK(maxError<T>([](T x) { return FastMath::sin(x); }, [](double x) { return std::sin(x); }, -10.0f, 10.0f) < 1.5e-6);
+    CHECK(maxError<T>([](T x) { return FastMath::sin(x); }, [](double x) { return std::sin(x); }, -100.0f, 100.0f) < 1e-5);
+    CHECK(maxError<T>([](T x) { return FastMath::cos(x); }, [](double x) { return std::cos(x); }, -10.0f, 10.0f) < 1.5e-6);
+    CHECK(maxError<T>([](T x) { return FastMath::tanh(x); }, [](double x) { return std::tanh(x); }, -20.0f, 20.0f) < 3e-6);
+    CHECK(maxError<T>([](T x) { return FastMath::exp2(x); }, [](double x) { return std::exp2(x); }, -30.0f, 30.0f, true) < 5e-6);
+    CHECK(maxError<T>([](T x) { return FastMath::exp(x); }, [](double x) { return std::exp(x); }, -20.0f, 20.0f, true) < 1e-5);
+    CHECK(maxError<T>([](T x) { return FastMath::wrapPhase(x); }, [](double x) { return x - std::floor(x); }, -50.0f, 50.0f) < 1e-5);
+}
+
+template<typename T, typename Fn>
+double nsPerValue(Fn fn) {
+    constexpr int W = width<T>();
+    constexpr int COUNT = 4096;
+    constexpr int ROUNDS = 64;
+    std::vector<float> input(COUNT);
+    for (int i = 0; i < COUNT; ++i) input[static_cast<size_t>(i)] = -8.0f + 16.0f * static_cast<float>(i) / COUNT;
+    T sink = T(ZERO);
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < ROUNDS; ++r) {
+        for (int i = 0; i < COUNT; i += W) sink = sink + fn(gather<T>(input.data() + i));
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    CHECK(std::isfinite(lane(sink, 0)));
+    return ns / (COUNT * ROUNDS);
+}
+
+template<typename T>
+void reportThroughput(const char* name) {
+    MESSAGE(name << " ns/value: sin " << nsPerValue<T>([](T x) { return FastMath::sin(x); })
+        << ", tanh " << nsPerValue<T>([](T x) { return FastMath::tanh(x); })
+        << ", exp2 " << nsPerValue<T>([](T x) { return FastMath::exp2(x); }));
+}
+}
+
+TEST_CASE("FastMath templates match std:: on float") {
+    checkAccuracy<float>();
+}
+
+TEST_CASE("FastMath templates match std:: on float_4") {
+    checkAccuracy<float_4>();
+}
+
+#if defined(__AVX2__)
+TEST_CASE("FastMath templates match std:: on float_8") {
+    checkAccuracy<float_8>();
+}
+#endif
+
+TEST_CASE("FastMath tanh saturates to exactly one") {
+    CHECK(FastMath::tanh(20.0f) == ONE);
+    CHECK(FastMath::tanh(-20.0f) == -ONE);
+}
+
+TEST_CASE("FastMath throughput against std::") {
+    MESSAGE("std ns/value: sin " << nsPerValue<float>([](float x) { return std::sin(x); })
+        << ", tanh " << nsPerValue<float>([](float x) { return std::tanh(x); })
+        << ", exp2 " << nsPerValue<float>([](float x) { return std::exp2(x); }));
+    reportThroughput<float>("float");
+    reportThroughput<float_4>("float_4");
+#if defined(__AVX2__)
+    reportThroughput<float_8>("float_8");
+#endif
+}
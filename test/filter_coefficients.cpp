@@ -0,0 +1,122 @@
+#include "doctest.h"
+#include "../src/dsp/filter_processor.hpp"
+#include <chrono>
+#include <cmath>
+
+using clonotribe::FilterCoefficientTable;
+using clonotribe::FilterProcessor;
+using clonotribe::LadderFilter;
+using clonotribe::MoogFilter;
+using clonotribe::MS20Filter;
+using clonotribe::SharedTable;
+using clonotribe::float_4;
+using CoefficientTables = SharedTable<FilterCoefficientTable, float>;
+
+namespace {
+float maxRowError(float_4 (FilterCoefficientTable::*at)(float) const, float_4 (*row)(float, float), float sampleRate) {
+    FilterCoefficientTable table(sampleRate);
+    float maxError = 0.0f;
+    for (float param = 0.0f; param <= 1.0f; param += 0.00037f) {
+        float_4 difference = (table.*at)(param) - row(param, sampleRate);
+        for (int lane = 0; lane < 4; ++lane) maxError = std::max(maxError, std::abs(difference[lane]));
+    }
+    return maxError;
+}
+
+// Sweeps the cutoff every sample, the case the table is for.
+template<typename Filter>
+double sweepNs(Filter& filter) {
+    constexpr int SAMPLES = 1 << 16;
+    float sink = 0.0f;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < SAMPLES; ++i) {
+        filter.setCutoff(0.5f + 0.4f * std::sin(0.001f * static_cast<float>(i)));
+        sink += filter.process((i & 32) ? 0.3f : -0.3f);
+    }
+    auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    CHECK(std::isfinite(sink));
+    return elapsed / SAMPLES;
+}
+}
+
+// Away from the clamps and the MS20 fade step the error is about 1e-5; the bounds are set by
+// the single cells that straddle those kinks.
+TEST_CASE("FilterCoefficientTable matches the direct formulas") {
+    for (float sampleRate : {44100.0f, 96000.0f, 176400.0f}) {
+        CAPTURE(sampleRate);
+        CHECK(maxRowError(&FilterCoefficientTable::ms20At, &FilterCoefficientTable::ms20Row, sampleRate) < 1e-2f);
+        CHECK(maxRowError(&FilterCoefficientTable::ladderAt, &FilterCoefficientTable::ladderRow, sampleRate) < 2e-3f);
+        CHECK(maxRowError(&FilterCoefficientTable::moogAt, &FilterCoefficientTable::moogRow, sampleRate) < 1e-4f);
+    }
+}
+
+TEST_CASE("FilterCoefficientTable is shared per sample rate") {
+    MS20Filter ms20A, ms20B;
+    FilterProcessor a(ms20A);
+    FilterProcessor b(ms20B);
+    for (FilterProcessor* processor : {&a, &b}) {
+        processor->prepareSampleRate(88200.0f);
+        processor->setSampleRate(88200.0f);
+    }
+    CHECK(CoefficientTables::users(88200.0f) == 2);
+    b.prepareSampleRate(96000.0f);
+    b.setSampleRate(96000.0f);
+    b.collectTables();
+    CHECK(CoefficientTables::users(88200.0f) == 1);
+    CHECK(CoefficientTables::users(96000.0f) == 1);
+}
+
+TEST_CASE("FilterCoefficientTable is released only after the audio thread moves on") {
+    MS20Filter ms20;
+    FilterProcessor processor(ms20);
+    processor.prepareSampleRate(88200.0f);
+    processor.setSampleRate(88200.0f);
+
+    // Prepared for a rate the audio thread is not running at yet: the current table stays.
+    processor.prepareSampleRate(176400.0f);
+    processor.update(0.5f, 0.2f);
+    processor.collectTables();
+    CHECK(CoefficientTables::users(88200.0f) == 1);
+    CHECK(CoefficientTables::users(176400.0f) == 1);
+
+    processor.setSampleRate(176400.0f);
+    CHECK(CoefficientTables::users(88200.0f) == 1);
+    processor.collectTables();
+    CHECK(CoefficientTables::users(88200.0f) == 0);
+}
+
+TEST_CASE("FilterCoefficientTable keeps the filters' sound") {
+    MS20Filter direct;
+    MS20Filter tabled;
+    MS20Filter owner;
+    FilterProcessor processor(owner);
+    processor.prepareSampleRate(88200.0f);
+    processor.setSampleRate(88200.0f);
+    direct.setSampleRate(88200.0f);
+    tabled.setSampleRate(88200.0f);
+    tabled.setCoefficientTable(CoefficientTables(88200.0f).get());
+    direct.setResonance(0.6f);
+    tabled.setResonance(0.6f);
+    float maxDifference = 0.0f;
+    for (int i = 0; i < 20000; ++i) {
+        float cutoff = 0.55f + 0.4f * std::sin(0.0007f * static_cast<float>(i));
+        direct.setCutoff(cutoff);
+        tabled.setCutoff(cutoff);
+        float input = (i & 64) ? 0.4f : -0.4f;
+        maxDifference = std::max(maxDifference, std::abs(direct.process(input) - tabled.process(input)));
+    }
+    CHECK(maxDifference < 1e-2f);
+}
+
+TEST_CASE("FilterCoefficientTable cutoff sweep cost") {
+    CoefficientTables table(44100.0f);
+    MS20Filter ms20Direct, ms20Tabled;
+    LadderFilter ladderDirect, ladderTabled;
+    MoogFilter moogDirect, moogTabled;
+    ms20Tabled.setCoefficientTable(table.get());
+    ladderTabled.setCoefficientTable(table.get());
+    moogTabled.setCoefficientTable(table.get());
+    MESSAGE("Cutoff sweep ns/sample direct/table: MS20 " << sweepNs(ms20Direct) << "/" << sweepNs(ms20Tabled)
+        << ", Ladder " << sweepNs(ladderDirect) << "/" << sweepNs(ladderTabled)
+        << ", Moog " << sweepNs(moogDirect) << "/" << sweepNs(moogTabled));
+}
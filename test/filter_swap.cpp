@@ -0,0 +1,124 @@
+#include "doctest.h"
+#include "../src/dsp/filter_processor.hpp"
+#include <cmath>
+#include <vector>
+
+using clonotribe::FilterProcessor;
+using clonotribe::FilterType;
+using clonotribe::LadderFilter;
+using clonotribe::MoogFilter;
+using clonotribe::MS20Filter;
+
+namespace {
+constexpr int SWAP_AT = 4000;
+constexpr int SAMPLES = 6000;
+
+enum class Swap { INSTANT, FADE, FADE_SEEDED };
+
+struct Rig {
+    MS20Filter ms20;
+    LadderFilter ladder;
+    MoogFilter moog;
+    FilterProcessor processor{ms20};
+
+    Rig() {
+        processor.setPointers(&ms20, &ladder, &moog);
+        processor.setSampleRate(44100.0f);
+        processor.setActive(true);
+    }
+
+    float step(int i) {
+        float input = 2.0f * std::fmod(110.0f * static_cast<float>(i) / 44100.0f, ONE) - ONE;
+        processor.update(0.6f, 0.3f);
+        return processor.processSample(input);
+    }
+};
+
+// Largest sample-to-sample jump right after switching from `from` to `to`.
+float jumpAfterSwap(FilterType from, FilterType to, Swap swap) {
+    Rig rig;
+    rig.processor.setFilterType(from, &rig.ms20, &rig.ladder, &rig.moog);
+    rig.processor.setStateSeeding(swap == Swap::FADE_SEEDED);
+    float previous = ZERO;
+    float jump = ZERO;
+    for (int i = 0; i < SAMPLES; ++i) {
+        if (i == SWAP_AT) {
+            if (swap == Swap::INSTANT) {
+                rig.processor.setFilterType(to, &rig.ms20, &rig.ladder, &rig.moog);
+            } else {
+                rig.processor.setType(to);
+            }
+        }
+        float y = rig.step(i);
+        if (i >= SWAP_AT && i < SWAP_AT + 8) jump = std::max(jump, std::abs(y - previous));
+        previous = y;
+    }
+    return jump;
+}
+
+// Largest jump a model produces on its own over the same stretch of input.
+float steadyJump(FilterType type) {
+    Rig rig;
+    rig.processor.setFilterType(type, &rig.ms20, &rig.ladder, &rig.moog);
+    float previous = ZERO;
+    float jump = ZERO;
+    for (int i = 0; i < SAMPLES; ++i) {
+        float y = rig.step(i);
+        if (i >= SWAP_AT) jump = std::max(jump, std::abs(y - previous));
+        previous = y;
+    }
+    return jump;
+}
+}
+
+TEST_CASE("FilterProcessor crossfades filter type changes") {
+    const FilterType types[] = {FilterType::MS20, FilterType::LADDER, FilterType::MOOG};
+    for (FilterType from : types) {
+        for (FilterType to : types) {
+            if (from == to) continue;
+            CAPTURE(static_cast<int>(from));
+            CAPTURE(static_cast<int>(to));
+            float steady = std::max(steadyJump(from), steadyJump(to));
+            float instant = jumpAfterSwap(from, to, Swap::INSTANT);
+            float faded = jumpAfterSwap(from, to, Swap::FADE);
+            float seeded = jumpAfterSwap(from, to, Swap::FADE_SEEDED);
+            MESSAGE("swap " << static_cast<int>(from) << "->" << static_cast<int>(to) << " jump: steady " << steady
+                << ", instant " << instant << ", faded " << faded << ", seeded " << seeded);
+            CHECK(faded <= steady * 1.1f);
+            CHECK(seeded <= steady * 1.1f);
+            CHECK(faded < instant);
+        }
+    }
+}
+
+TEST_CASE("FilterProcessor runs two models only during the fade") {
+    Rig rig;
+    for (int i = 0; i < 100; ++i) rig.step(i);
+    rig.processor.setType(FilterType::LADDER);
+    rig.processor.update(0.6f, 0.3f);
+    CHECK(rig.processor.isFading());
+    CHECK(rig.processor.getType() == FilterType::LADDER);
+
+    // A second change waits for the running fade.
+    rig.processor.setType(FilterType::MOOG);
+    for (int i = 0; i < 220; ++i) {
+        CHECK(rig.processor.isFading());
+        CHECK(rig.processor.getType() == FilterType::LADDER);
+        (void)rig.processor.processSample(ZERO);
+        rig.processor.update(0.6f, 0.3f);
+        if (i < 219) CHECK(rig.processor.getType() == FilterType::LADDER);
+    }
+    CHECK(rig.processor.getType() == FilterType::MOOG);
+}
+
+TEST_CASE("FilterProcessor applies a solver request on the next update") {
+    Rig rig;
+    rig.processor.setSolver(clonotribe::FilterSolver::ZDF);
+    CHECK(rig.processor.getSolver() == clonotribe::FilterSolver::ZDF);
+    CHECK(rig.ms20.getSolver() == clonotribe::FilterSolver::EULER);
+    CHECK(rig.ladder.getSolver() == clonotribe::FilterSolver::EULER);
+
+    rig.processor.update(0.6f, 0.3f);
+    CHECK(rig.ms20.getSolver() == clonotribe::FilterSolver::ZDF);
+    CHECK(rig.ladder.getSolver() == clonotribe::FilterSolver::ZDF);
+}
@@ -0,0 +1,343 @@
+#include "doctest.h"
+#include "../src/dsp/vcf/ms20.hpp"
+#include "../src/dsp/vcf/ladder.hpp"
+#include "../src/dsp/vcf/moog.hpp"
+#include <cmath>
+#include <vector>
+
+using clonotribe::float_4;
+
+// The scalar filters as they were before being templated on the sample type.
+namespace legacy {
+using namespace clonotribe;
+
+class MS20Filter {
+public:
+    MS20Filter() noexcept {
+        updateCoefficients();
+    }
+
+    void setSampleRate(float sr) noexcept {
+        sampleRate = std::max(FilterCoefficientTable::MIN_SAMPLE_RATE, sr);
+        noiseGen.setSeed(static_cast<uint32_t>(sr));
+        updateCoefficients();
+    }
+
+
+    void setCutoff(float param) noexcept {
+        param = std::clamp(param, 0.f, ONE);
+        if (param == cutoffParam) return;
+        cutoffParam = param;
+        updateCoefficients();
+    }
+
+    void setResonance(float param) noexcept {
+        param = std::clamp(param, 0.f, ONE);
+        if (param == resonanceParam) return;
+        resonanceParam = param;
+        updateCoefficients();
+    }
+
+    void setActive(bool isActive) noexcept {
+        active = isActive;
+        if (!active) reset();
+    }
+
+    [[nodiscard]] float process(float input) noexcept {
+        if (!active) {
+            return ZERO;
+        }
+
+        if (!std::isfinite(input)) {
+            reset();
+            return ZERO;
+        }
+
+        float drivenInput = input * drive;
+        drivenInput = saturate(drivenInput);
+        
+        float hp = saturate(drivenInput - resonance * s2 - s1);
+        
+        s1 += f * saturate(hp);
+        s2 += f * saturate(s1);
+
+        float output = s2 * cutoffFade;
+
+        if (oscGain > ZERO) {
+            oscPhase += oscIncrement;
+            if (oscPhase >= TWO * FastMath::PI) oscPhase -= TWO * FastMath::PI;
+            output = output * (ONE - oscGain * 0.3f) + FastMath::fastSin(oscPhase) * oscLevel;
+        }
+
+        return saturate(output * finalGain);
+    }
+
+    void reset() noexcept {
+        s1 = s2 = ZERO;
+        oscPhase = ZERO;
+    }
+    
+private:
+    float s1 = 0.f, s2 = ZERO;
+    float cutoffParam = HALF;
+    float resonanceParam = ZERO;
+    float sampleRate = 44100.f;
+    float oscPhase = ZERO;
+    bool active = true;
+
+    // Derived from the parameters and sample rate, so oversampled runs only pay for the kernel.
+    float f = ZERO;
+    float resonance = ZERO;
+    float drive = ONE;
+    float cutoffFade = ONE;
+    float oscGain = ZERO;
+    float oscIncrement = ZERO;
+    float oscLevel = ZERO;
+    float finalGain = ONE;
+
+    NoiseGenerator noiseGen;
+    const FilterCoefficientTable* coefficientTable = nullptr;
+
+    void updateCoefficients() noexcept {
+        float_4 row = coefficientTable && coefficientTable->sampleRate == sampleRate
+            ? coefficientTable->ms20At(cutoffParam)
+            : FilterCoefficientTable::ms20Row(cutoffParam, sampleRate);
+        f = row[0];
+        cutoffFade = row[1];
+        oscIncrement = row[2];
+
+        resonance = calculateResonance(resonanceParam);
+        drive = ONE + resonanceParam * 1.2f;
+        oscGain = resonanceParam > 0.75f ? (resonanceParam - 0.75f) * 4.0f : ZERO;
+        // The cutoff is above a quarter of the sample rate.
+        oscLevel = oscGain * 0.15f * (oscIncrement > HALF * FastMath::PI ? HALF : ONE);
+        finalGain = 1.1f + resonanceParam * 0.3f;
+    }
+
+    [[nodiscard]] inline float calculateResonance(float param) const noexcept {
+        param = std::clamp(param, 0.f, ONE);
+        return param * param * 6.0f + param * 1.5f;
+    }
+
+    [[nodiscard]] inline float saturate(float x) const noexcept {
+        x = std::clamp(x, -4.f, 4.f);
+        if (x > ZERO) {
+            return x / (ONE + x * 0.4f);
+        } else {
+            return x / (ONE + std::abs(x) * HALF);
+        }
+    }    
+};
+
+class LadderFilter {
+public:
+    LadderFilter() noexcept {
+        updateCoefficients();
+    }
+
+    void setSampleRate(float sr) noexcept {
+        sampleRate = std::max(FilterCoefficientTable::MIN_SAMPLE_RATE, sr);
+        updateCoefficients();
+    }
+
+
+    void setCutoff(float param) noexcept {
+        param = std::clamp(param, 0.f, ONE);
+        if (param == cutoffParam) return;
+        cutoffParam = param;
+        updateCoefficients();
+    }
+
+    void setResonance(float param) noexcept {
+        param = std::clamp(param, 0.f, ONE);
+        if (param == resonanceParam) return;
+        resonanceParam = param;
+        updateCoefficients();
+    }
+
+    void setActive(bool isActive) noexcept {
+        active = isActive;
+        if (!active) reset();
+    }
+
+    [[nodiscard]] float process(float input) noexcept {
+        if (!active) return ZERO;
+        float x = input - res * y4;
+        y1 += f * (FastMath::fastTanh(x - y1));
+        y2 += f * (FastMath::fastTanh(y1 - y2));
+        y3 += f * (FastMath::fastTanh(y2 - y3));
+        y4 += f * (FastMath::fastTanh(y3 - y4));
+        return y4;
+    }
+
+    void reset() noexcept {
+        y1 = y2 = y3 = y4 = ZERO;
+    }
+
+private:
+    float y1 = 0.f, y2 = 0.f, y3 = 0.f, y4 = ZERO;
+    float cutoffParam = HALF;
+    float resonanceParam = ZERO;
+    float sampleRate = 44100.f;
+    bool active = true;
+    const FilterCoefficientTable* coefficientTable = nullptr;
+    float f = ZERO;
+    float res = ZERO;
+
+    void updateCoefficients() noexcept {
+        float_4 row = coefficientTable && coefficientTable->sampleRate == sampleRate
+            ? coefficientTable->ladderAt(cutoffParam)
+            : FilterCoefficientTable::ladderRow(cutoffParam, sampleRate);
+        f = row[0];
+        res = resonanceParam * 4.0f;
+    }
+};
+
+class MoogFilter {
+public:
+    MoogFilter() noexcept {
+        updateCoefficients();
+    }
+
+    void setSampleRate(float sr) noexcept {
+        sampleRate = std::max(FilterCoefficientTable::MIN_SAMPLE_RATE, sr);
+        updateCoefficients();
+    }
+
+
+    void setCutoff(float param) noexcept {
+        param = std::clamp(param, 0.f, ONE);
+        if (param == cutoffParam) return;
+        cutoffParam = param;
+        updateCoefficients();
+    }
+
+    void setResonance(float param) noexcept {
+        param = std::clamp(param, 0.f, ONE);
+        if (param == resonanceParam) return;
+        resonanceParam = param;
+        updateCoefficients();
+    }
+
+    void setActive(bool isActive) noexcept {
+        active = isActive;
+        if (!active) reset();
+    }
+
+    [[nodiscard]] float process(float input) noexcept {
+        if (!active) return ZERO;
+        float in = input - fb * y4;
+        in = FastMath::fastTanh(in);
+        y1 = FastMath::fastTanh(in * f + FastMath::fastTanh(y1) * (ONE - f));
+        y2 = FastMath::fastTanh(y1 * f + FastMath::fastTanh(y2) * (ONE - f));
+        y3 = FastMath::fastTanh(y2 * f + FastMath::fastTanh(y3) * (ONE - f));
+        y4 = FastMath::fastTanh(y3 * f + FastMath::fastTanh(y4) * (ONE - f));
+        return y4;
+    }
+
+    void reset() noexcept {
+        y1 = y2 = y3 = y4 = ZERO;
+    }
+
+private:
+    float y1 = 0.f, y2 = 0.f, y3 = 0.f, y4 = ZERO;
+    float cutoffParam = HALF;
+    float resonanceParam = ZERO;
+    float sampleRate = 44100.f;
+    bool active = true;
+    const FilterCoefficientTable* coefficientTable = nullptr;
+    float f = ZERO;
+    float fb = ZERO;
+
+    void updateCoefficients() noexcept {
+        float_4 row = coefficientTable && coefficientTable->sampleRate == sampleRate
+            ? coefficientTable->moogAt(cutoffParam)
+            : FilterCoefficientTable::moogRow(cutoffParam, sampleRate);
+        f = row[0];
+        fb = resonanceParam * row[1];
+    }
+};
+}
+
+namespace {
+// A swept cutoff, a resonance ramp into self-oscillation and a square input. Only the MS20
+// guards against non-finite input, so only its run includes a few.
+struct Drive {
+    float cutoff;
+    float resonance;
+    float input;
+};
+
+std::vector<Drive> drive(bool nonFinite, int lane = 0) {
+    std::vector<Drive> frames;
+    for (int i = 0; i < 12000; ++i) {
+        float t = static_cast<float>(i);
+        float input = ((i + 17 * lane) & 64) ? 0.5f : -0.5f;
+        if (nonFinite && i == 5000 + lane) input = NAN;
+        if (nonFinite && i == 7000) input = INFINITY;
+        frames.push_back({0.5f + 0.45f * std::sin(0.0011f * t + static_cast<float>(lane)), std::min(t / 10000.0f, 1.0f), input});
+    }
+    return frames;
+}
+
+template<typename Reference, typename Filter>
+void checkScalarMatch(bool nonFinite, float sampleRate = 88200.0f) {
+    Reference reference;
+    Filter filter;
+    reference.setSampleRate(sampleRate);
+    filter.setSampleRate(sampleRate);
+    int mismatches = 0;
+    for (const Drive& frame : drive(nonFinite)) {
+        reference.setCutoff(frame.cutoff);
+        filter.setCutoff(frame.cutoff);
+        reference.setResonance(frame.resonance);
+        filter.setResonance(frame.resonance);
+        float expected = reference.process(frame.input);
+        float actual = filter.process(frame.input);
+        if (!(std::abs(expected - actual) <= 1e-6f)) ++mismatches;
+    }
+    CHECK(mismatches == 0);
+}
+
+// Each float_4 lane must follow the scalar filter fed that lane's input.
+template<typename Filter, typename LaneFilter>
+void checkLanes(bool nonFinite) {
+    Filter lanes;
+    LaneFilter scalar[4];
+    std::vector<Drive> inputs[4];
+    lanes.setSampleRate(88200.0f);
+    for (int lane = 0; lane < 4; ++lane) {
+        scalar[lane].setSampleRate(88200.0f);
+        inputs[lane] = drive(nonFinite, lane);
+    }
+    float maxDifference = 0.0f;
+    for (size_t i = 0; i < inputs[0].size(); ++i) {
+        const Drive& shared = inputs[0][i];
+        lanes.setCutoff(shared.cutoff);
+        lanes.setResonance(shared.resonance);
+        float_4 input(inputs[0][i].input, inputs[1][i].input, inputs[2][i].input, inputs[3][i].input);
+        float_4 output = lanes.process(input);
+        for (int lane = 0; lane < 4; ++lane) {
+            scalar[lane].setCutoff(shared.cutoff);
+            scalar[lane].setResonance(shared.resonance);
+            float expected = scalar[lane].process(inputs[lane][i].input);
+            float difference = std::abs(expected - output[lane]);
+            maxDifference = std::isfinite(difference) ? std::max(maxDifference, difference) : INFINITY;
+        }
+    }
+    CHECK(maxDifference < 1e-6f);
+}
+}
+
+TEST_CASE("Templated filters match the scalar reference") {
+    checkScalarMatch<legacy::MS20Filter, clonotribe::MS20Filter>(true);
+    checkScalarMatch<legacy::LadderFilter, clonotribe::LadderFilter>(false);
+    // The Moog stages now scale their saturation with the rate; at 44.1 kHz it is unscaled.
+    checkScalarMatch<legacy::MoogFilter, clonotribe::MoogFilter>(false, 44100.0f);
+}
+
+TEST_CASE("Templated filters run independent float_4 lanes") {
+    checkLanes<clonotribe::TMS20Filter<float_4>, clonotribe::MS20Filter>(true);
+    checkLanes<clonotribe::TLadderFilter<float_4>, clonotribe::LadderFilter>(false);
+    checkLanes<clonotribe::TMoogFilter<float_4>, clonotribe::MoogFilter>(false);
+}
@@ -0,0 +1,69 @@
+#include "doctest.h"
+#include "../src/dsp/kernels.hpp"
+#include "../src/dsp/oversampler.hpp"
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+using clonotribe::Kernels;
+using clonotribe::Oversampler;
+
+namespace {
+constexpr Kernels::Isa ALL_ISAS[] = {Kernels::Isa::GENERIC, Kernels::Isa::AVX2};
+
+double referenceHalfband(const std::vector<float>& window, const std::vector<float>& coefficients, int taps) {
+    double sum = 0.0;
+    for (int k = 0; k < taps; ++k) {
+        auto index = static_cast<size_t>(k);
+        sum += static_cast<double>(coefficients[index]) * (window[static_cast<size_t>(taps - 1 - k)] + window[static_cast<size_t>(taps + k)]);
+    }
+    return sum;
+}
+}
+
+TEST_CASE("Kernels select only supported variants") {
+    const Kernels::Isa detected = Kernels::detect();
+    CHECK(Kernels::isSupported(detected));
+    CHECK(Kernels::select(Kernels::Isa::GENERIC));
+    CHECK(Kernels::selected() == Kernels::Isa::GENERIC);
+    if (!Kernels::isSupported(Kernels::Isa::AVX2)) {
+        CHECK_FALSE(Kernels::select(Kernels::Isa::AVX2));
+        CHECK(Kernels::selected() == Kernels::Isa::GENERIC);
+    }
+    Kernels::select(detected);
+}
+
+TEST_CASE("Kernels halfband variants match the reference") {
+    for (Kernels::Isa isa : ALL_ISAS) {
+        if (!Kernels::select(isa)) continue;
+        CAPTURE(Kernels::name(isa));
+        for (int taps : {1, 4, 7, 12, 13, 20}) {
+            std::vector<float> window(static_cast<size_t>(2 * taps));
+            std::vector<float> coefficients(static_cast<size_t>(taps));
+            for (size_t i = 0; i < window.size(); ++i) window[i] = std::sin(0.7f * static_cast<float>(i) + 0.3f);
+            for (size_t i = 0; i < coefficients.size(); ++i) coefficients[i] = 0.1f / static_cast<float>(i + 1);
+            float sum = Kernels::active().halfband(window.data(), coefficients.data(), taps);
+            CHECK(std::abs(sum - referenceHalfband(window, coefficients, taps)) < 1e-6);
+        }
+    }
+    Kernels::select(Kernels::detect());
+}
+
+// Bench mode: forces every variant this machine supports through the same HQ oversampling run.
+TEST_CASE("Kernels oversampler throughput per variant") {
+    constexpr int SAMPLES = 1 << 18;
+    for (Kernels::Isa isa : ALL_ISAS) {
+        if (!Kernels::select(isa)) continue;
+        Oversampler oversampler;
+        oversampler.setFactor(Oversampler::factorFor(Oversampler::Quality::HQ));
+        float sink = 0.0f;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < SAMPLES; ++i) {
+            float x = (i & 64) ? 0.5f : -0.5f;
+            sink += oversampler.process(x, [](float v) { return v * 0.9f; });
+        }
+        auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        MESSAGE(Kernels::name(isa) << " HQ oversampler: " << elapsed / SAMPLES << " ns/sample (" << sink << ")");
+    }
+    Kernels::select(Kernels::detect());
+}
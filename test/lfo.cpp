@@ -0,0 +1,94 @@
+#include "doctest.h"
+#include "../src/dsp/lfo.hpp"
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+using clonotribe::LFO;
+
+namespace {
+constexpr float SAMPLE_RATE = 44100.0f;
+constexpr float SAMPLE_TIME = ONE / SAMPLE_RATE;
+
+std::vector<float> render(LFO& lfo, LFO::Mode mode, LFO::Waveform waveform, float rate, int samples) {
+    std::vector<float> out(static_cast<size_t>(samples));
+    for (float& y : out) y = lfo.process(mode, rate, false, false, waveform, ONE, SAMPLE_TIME);
+    return out;
+}
+
+// The slow range maps rate 0..1 exponentially onto 0.05..18 Hz.
+float slowFrequency(float rate) {
+    return 0.05f * std::pow(18.0f / 0.05f, rate);
+}
+}
+
+TEST_CASE("LFO sample and hold repeats for the same seed") {
+    LFO a;
+    LFO b;
+    LFO c;
+    a.setSeed(7);
+    b.setSeed(7);
+    c.setSeed(8);
+    const auto first = render(a, LFO::Mode::FAST, LFO::Waveform::SAMPLE_HOLD, 0.3f, 44100);
+    CHECK(first == render(b, LFO::Mode::FAST, LFO::Waveform::SAMPLE_HOLD, 0.3f, 44100));
+    CHECK(first != render(c, LFO::Mode::FAST, LFO::Waveform::SAMPLE_HOLD, 0.3f, 44100));
+}
+
+TEST_CASE("Slow LFO at control rate follows the per-sample waveform") {
+    const float rate = 0.6f;
+    const float frequency = slowFrequency(rate);
+    LFO lfo;
+    const auto out = render(lfo, LFO::Mode::SLOW, LFO::Waveform::TRIANGLE, rate, 2 * static_cast<int>(SAMPLE_RATE));
+    // The interpolated output runs one block behind the waveform.
+    const float lag = static_cast<float>(LFO::CONTROL_INTERVAL) * SAMPLE_TIME;
+    float maxError = ZERO;
+    for (size_t i = 0; i < out.size(); ++i) {
+        float phase = std::fmod(frequency * (static_cast<float>(i + 1) * SAMPLE_TIME - lag) + ONE, ONE);
+        float expected = phase < HALF ? 4.0f * phase - ONE : 3.0f - 4.0f * phase;
+        if (i >= static_cast<size_t>(LFO::CONTROL_INTERVAL)) maxError = std::max(maxError, std::abs(out[i] - expected));
+    }
+    MESSAGE("triangle at " << frequency << " Hz, max error " << maxError);
+    // Only the corners are cut, by at most one block of slope.
+    CHECK(maxError <= 4.0f * frequency * lag + 1e-3f);
+}
+
+TEST_CASE("Slow LFO keeps its frequency") {
+    for (float rate : {0.4f, 0.6f, 0.9f}) {
+        CAPTURE(rate);
+        LFO lfo;
+        const int samples = 20 * static_cast<int>(SAMPLE_RATE);
+        int wraps = 0;
+        int firstWrap = -1;
+        int lastWrap = -1;
+        for (int i = 0; i < samples; ++i) {
+            (void)lfo.process(LFO::Mode::SLOW, rate, false, false, LFO::Waveform::SAW, ONE, SAMPLE_TIME);
+            if (lfo.phaseWrapped()) {
+                if (firstWrap < 0) firstWrap = i;
+                lastWrap = i;
+                ++wraps;
+            }
+        }
+        REQUIRE(wraps >= 2);
+        // Wraps land on block boundaries, so time whole periods rather than counting them.
+        float measured = static_cast<float>(wraps - 1) * SAMPLE_RATE / static_cast<float>(lastWrap - firstWrap);
+        CHECK(measured == doctest::Approx(slowFrequency(rate)).epsilon(0.01));
+    }
+}
+
+TEST_CASE("Slow LFO costs less than an audio-rate LFO") {
+    auto time = [](LFO::Mode mode) {
+        LFO lfo;
+        float sink = ZERO;
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < 4000000; ++i) {
+            sink += lfo.process(mode, 0.5f + 1e-9f * static_cast<float>(i & 1), false, false, LFO::Waveform::TRIANGLE, ONE, SAMPLE_TIME);
+        }
+        const auto end = std::chrono::steady_clock::now();
+        CHECK(std::isfinite(sink));
+        return std::chrono::duration<double, std::nano>(end - start).count() / 4000000.0;
+    };
+    const double fast = time(LFO::Mode::FAST);
+    const double slow = time(LFO::Mode::SLOW);
+    MESSAGE("LFO ns/sample: fast " << fast << ", slow " << slow);
+    CHECK(slow < fast);
+}
@@ -0,0 +1,150 @@
+#include "doctest.h"
+#include "../src/dsp/sequencer/midi_file.hpp"
+#include <sstream>
+#include <vector>
+
+using namespace clonotribe;
+
+namespace {
+Sequencer::Step note(float pitch, float gateTime, bool accent = false, bool glide = false) {
+    Sequencer::Step step;
+    step.pitch = pitch;
+    step.gate = 5.0f;
+    step.gateTime = gateTime;
+    step.accent = accent;
+    step.glide = glide;
+    return step;
+}
+
+MidiPattern roundTrip(const MidiPattern& pattern) {
+    std::stringstream file;
+    REQUIRE(writeMidiPatterns(file, {pattern}));
+    std::vector<MidiPattern> patterns;
+    REQUIRE(readMidiPatterns(file, patterns));
+    REQUIRE(patterns.size() == 1);
+    return patterns.front();
+}
+
+MidiPattern sixteenStepPattern() {
+    MidiPattern pattern;
+    pattern.stepCount = Sequencer::MAX_STEPS;
+    for (int i = 0; i < Sequencer::MAX_STEPS; ++i) {
+        pattern.steps[static_cast<size_t>(i)] = note(static_cast<float>(i % 5) / 12.0f, 0.25f * static_cast<float>(1 + i % 4));
+    }
+    pattern.steps[1].accent = true;
+    // Glide between two different pitches, then between two equal ones.
+    pattern.steps[4] = note(ZERO, 0.5f);
+    pattern.steps[5] = note(7.0f / 12.0f, 0.5f, false, true);
+    pattern.steps[8] = note(ONE, 0.5f);
+    pattern.steps[9] = note(ONE, 0.75f, true, true);
+    pattern.steps[11].muted = true;
+    pattern.steps[13].skipped = true;
+
+    pattern.drums.set(0, 0, true);
+    pattern.drums.set(0, 8, true);
+    pattern.drums.toggleAccent(0, 12);
+    pattern.drums.set(1, 4, true);
+    pattern.drums.toggleAccent(1, 15);
+    for (int i = 0; i < Sequencer::MAX_STEPS; i += 2) pattern.drums.set(2, i, true);
+    pattern.drums.toggleAccent(2, 6);
+    return pattern;
+}
+}
+
+TEST_CASE("MIDI round trip keeps synth steps") {
+    const MidiPattern original = sixteenStepPattern();
+    const MidiPattern loaded = roundTrip(original);
+    CHECK(loaded.stepCount == Sequencer::MAX_STEPS);
+
+    for (int i = 0; i < Sequencer::MAX_STEPS; ++i) {
+        CAPTURE(i);
+        const auto& a = original.steps[static_cast<size_t>(i)];
+        const auto& b = loaded.steps[static_cast<size_t>(i)];
+        CHECK(b.skipped == a.skipped);
+        if (a.skipped || a.muted) {
+            CHECK(b.muted);
+            continue;
+        }
+        CHECK_FALSE(b.muted);
+        CHECK(b.pitch == doctest::Approx(a.pitch));
+        CHECK(b.accent == a.accent);
+        CHECK(b.glide == a.glide);
+        // A step gliding into the next one is written legato and reads back at full length.
+        bool legato = i + 1 < Sequencer::MAX_STEPS && original.steps[static_cast<size_t>(i + 1)].glide;
+        CHECK(b.gateTime == doctest::Approx(legato ? ONE : a.gateTime));
+    }
+}
+
+TEST_CASE("MIDI round trip keeps a glide between equal pitches") {
+    const MidiPattern loaded = roundTrip(sixteenStepPattern());
+    CHECK(loaded.steps[9].glide);
+    CHECK(loaded.steps[9].accent);
+    CHECK(loaded.steps[9].gateTime == doctest::Approx(0.75f));
+}
+
+TEST_CASE("MIDI round trip keeps drum lanes and accents") {
+    const MidiPattern original = sixteenStepPattern();
+    const MidiPattern loaded = roundTrip(original);
+    CHECK(loaded.drums == original.drums);
+}
+
+TEST_CASE("MIDI round trip keeps an eight-step pattern") {
+    MidiPattern original;
+    for (int i = 0; i < Sequencer::DEFAULT_STEPS; ++i) {
+        original.steps[static_cast<size_t>(i)] = note(static_cast<float>(i) / 12.0f, HALF);
+    }
+    original.steps[7].skipped = true;
+    original.drums.set(1, 3, true);
+
+    const MidiPattern loaded = roundTrip(original);
+    CHECK(loaded.stepCount == Sequencer::DEFAULT_STEPS);
+    CHECK(loaded.steps[7].skipped);
+    CHECK(loaded.steps[6].pitch == doctest::Approx(0.5f));
+    CHECK(loaded.drums == original.drums);
+}
+
+namespace {
+// A one-track file with the given division whose track holds `body` followed by end of track.
+std::string midiFile(uint16_t division, const std::string& body) {
+    std::string track = body + std::string("\x00\xFF\x2F\x00", 4);
+    std::string file("MThd\x00\x00\x00\x06\x00\x01\x00\x01", 12);
+    file += static_cast<char>(division >> 8);
+    file += static_cast<char>(division & 0xFF);
+    file += "MTrk";
+    for (int shift = 24; shift >= 0; shift -= 8) file += static_cast<char>((track.size() >> shift) & 0xFF);
+    return file + track;
+}
+
+const std::string MAX_DELTA("\xFF\xFF\xFF\x7F", 4);
+const std::string NOTE_ON("\x90\x3C\x64", 3);
+}
+
+TEST_CASE("MIDI import rejects a delta that would need too many patterns") {
+    std::stringstream file(midiFile(96, MAX_DELTA + NOTE_ON));
+    std::vector<MidiPattern> patterns;
+    CHECK_FALSE(readMidiPatterns(file, patterns));
+    CHECK(patterns.size() <= MidiPatternParser::MAX_PATTERNS);
+}
+
+TEST_CASE("MIDI import does not wrap the tick past 32 bits") {
+    // Seventeen maximal deltas at one tick per step run the tick past 2^32.
+    std::string body;
+    for (int i = 0; i < 17; ++i) body += MAX_DELTA + std::string("\xFF\x01\x00", 3);
+    std::stringstream file(midiFile(4, body + std::string("\x00", 1) + NOTE_ON));
+    std::vector<MidiPattern> patterns;
+    CHECK_FALSE(readMidiPatterns(file, patterns));
+    CHECK(patterns.size() <= MidiPatternParser::MAX_PATTERNS);
+}
+
+TEST_CASE("MIDI import accepts a note on the last pattern it allows") {
+    // 1023 patterns of sixteen steps at 24 ticks per step.
+    const uint32_t tick = (MidiPatternParser::MAX_PATTERNS - 1) * Sequencer::MAX_STEPS * MidiFormat::TICKS_PER_STEP;
+    std::string delta;
+    for (int shift = 21; shift > 0; shift -= 7) delta += static_cast<char>(0x80 | ((tick >> shift) & 0x7F));
+    delta += static_cast<char>(tick & 0x7F);
+    std::stringstream file(midiFile(MidiFormat::PPQ, delta + NOTE_ON));
+    std::vector<MidiPattern> patterns;
+    REQUIRE(readMidiPatterns(file, patterns));
+    CHECK(patterns.size() == MidiPatternParser::MAX_PATTERNS);
+    CHECK_FALSE(patterns.back().steps[0].muted);
+}
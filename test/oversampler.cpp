@@ -0,0 +1,116 @@
+#include "doctest.h"
+#include "../src/dsp/oversampler.hpp"
+#include "../src/dsp/vco.hpp"
+#include "../src/dsp/vcf/ms20.hpp"
+#include "../src/dsp/distortion.hpp"
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+using clonotribe::Distortion;
+using clonotribe::FastMath;
+using clonotribe::MS20Filter;
+using clonotribe::Oversampler;
+using clonotribe::VCO;
+
+namespace {
+constexpr int N = 4096;
+constexpr int FUNDAMENTAL_BIN = 373;
+
+// Energy of bins that are not harmonics of the test tone relative to the harmonic energy.
+double aliasRatio(int factor) {
+    Oversampler oversampler;
+    oversampler.setFactor(factor);
+    std::vector<double> signal(N);
+    const double omega = 2.0 * M_PI * FUNDAMENTAL_BIN / N;
+    for (int i = -N; i < N; ++i) {
+        float x = static_cast<float>(std::sin(omega * i));
+        float out = oversampler.process(x, [](float v) { return std::clamp(v * 4.0f, -ONE, ONE); });
+        if (i >= 0) signal[static_cast<size_t>(i)] = out;
+    }
+    double harmonic = 0.0;
+    double alias = 0.0;
+    for (int k = 1; k < N / 2; ++k) {
+        double re = 0.0;
+        double im = 0.0;
+        for (int n = 0; n < N; ++n) {
+            double phase = 2.0 * M_PI * static_cast<double>((static_cast<long>(k) * n) % N) / N;
+            re += signal[static_cast<size_t>(n)] * std::cos(phase);
+            im -= signal[static_cast<size_t>(n)] * std::sin(phase);
+        }
+        double power = re * re + im * im;
+        if (k % FUNDAMENTAL_BIN == 0) {
+            harmonic += power;
+        } else {
+            alias += power;
+        }
+    }
+    return alias / harmonic;
+}
+
+float passbandGain(int factor, float frequency) {
+    Oversampler oversampler;
+    oversampler.setFactor(factor);
+    double inEnergy = 0.0;
+    double outEnergy = 0.0;
+    for (int i = 0; i < 48000; ++i) {
+        float x = static_cast<float>(std::sin(2.0 * M_PI * frequency * i / 48000.0));
+        float y = oversampler.process(x, [](float v) { return v; });
+        if (i >= 1000) {
+            inEnergy += static_cast<double>(x) * x;
+            outEnergy += static_cast<double>(y) * y;
+        }
+    }
+    return static_cast<float>(std::sqrt(outEnergy / inEnergy));
+}
+}
+
+TEST_CASE("Oversampler is transparent in the passband") {
+    for (int factor : {2, 4}) {
+        for (float frequency : {100.0f, 1000.0f, 10000.0f, 16000.0f}) {
+            CAPTURE(factor);
+            CAPTURE(frequency);
+            CHECK(std::abs(20.0f * std::log10(passbandGain(factor, frequency))) < 0.1f);
+        }
+    }
+}
+
+TEST_CASE("Oversampling reduces aliasing of a hard clipper") {
+    double eco = aliasRatio(1);
+    double normal = aliasRatio(2);
+    double hq = aliasRatio(4);
+    MESSAGE("alias/harmonic 1x " << 10.0 * std::log10(eco) << " dB, 2x " << 10.0 * std::log10(normal)
+        << " dB, 4x " << 10.0 * std::log10(hq) << " dB");
+    CHECK(normal < eco * 0.5);
+    CHECK(hq < normal * 0.5);
+}
+
+TEST_CASE("Oversampled voice benchmark") {
+    using Clock = std::chrono::steady_clock;
+    constexpr int SAMPLES = 1 << 17;
+    double baseline = 0.0;
+    for (int factor : {1, 2, 4}) {
+        Oversampler oversampler;
+        oversampler.setFactor(factor);
+        VCO vco;
+        vco.setPitch(ONE);
+        MS20Filter filter;
+        filter.setSampleRate(48000.0f * static_cast<float>(factor));
+        filter.setCutoff(0.7f);
+        filter.setResonance(0.4f);
+        Distortion distortion;
+        distortion.setOversampling(factor);
+        const float sampleTime = ONE / (48000.0f * static_cast<float>(factor));
+        float sink = ZERO;
+        auto start = Clock::now();
+        for (int i = 0; i < SAMPLES; ++i) {
+            sink += oversampler.process(ZERO, [&](float external) {
+                return distortion.process(filter.process(vco.process<VCO::Waveform::SAW>(sampleTime) + external), HALF);
+            });
+        }
+        double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / SAMPLES;
+        if (factor == 1) baseline = ns;
+        MESSAGE(factor << "x voice: " << ns << " ns/sample (" << ns / baseline << "x)");
+        CHECK(std::isfinite(sink));
+    }
+}
@@ -0,0 +1,80 @@
+#include "doctest.h"
+#include "../src/dsp/parameter_ramp.hpp"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using clonotribe::ParameterRamp;
+
+namespace {
+std::vector<float> stepResponse(float sampleRate, float timeMs, int samples) {
+    ParameterRamp ramp(timeMs);
+    ramp.setSampleRate(sampleRate);
+    ramp.reset(ZERO);
+    ramp.setTarget(ONE);
+    std::vector<float> out(static_cast<size_t>(samples));
+    for (float& y : out) y = ramp.process();
+    return out;
+}
+}
+
+TEST_CASE("ParameterRamp moves linearly and lands on the target") {
+    const std::vector<float> out = stepResponse(48000.0f, 5.0f, 400);
+    // 5 ms at 48 kHz.
+    for (int i = 0; i < 240; ++i) {
+        CAPTURE(i);
+        CHECK(out[static_cast<size_t>(i)] == doctest::Approx(static_cast<float>(i + 1) / 240.0f).epsilon(1e-5));
+    }
+    for (size_t i = 239; i < out.size(); ++i) CHECK(out[i] == ONE);
+}
+
+TEST_CASE("ParameterRamp timing does not depend on the sample rate") {
+    for (float sampleRate : {44100.0f, 48000.0f, 96000.0f, 192000.0f}) {
+        CAPTURE(sampleRate);
+        ParameterRamp ramp(2.0f);
+        ramp.setSampleRate(sampleRate);
+        CHECK(static_cast<float>(ramp.getLength()) / sampleRate == doctest::Approx(0.002f).epsilon(0.01));
+
+        // Halfway through the ramp after 1 ms, whatever the rate.
+        const std::vector<float> out = stepResponse(sampleRate, 2.0f, static_cast<int>(sampleRate * 0.001f));
+        CHECK(out.back() == doctest::Approx(HALF).epsilon(0.02));
+    }
+}
+
+TEST_CASE("ParameterRamp follows a moving target without an exponential tail") {
+    ParameterRamp ramp(2.0f);
+    ramp.setSampleRate(44100.0f);
+    const int length = ramp.getLength();
+    const float sweepSlope = ONE / 4410.0f;
+    float target = ZERO;
+    float maxStep = ZERO;
+    float maxLag = ZERO;
+    float previous = ZERO;
+    for (int i = 0; i < 4410; ++i) {
+        target += sweepSlope;
+        float y = ramp.process(target);
+        maxStep = std::max(maxStep, std::abs(y - previous));
+        maxLag = std::max(maxLag, target - y);
+        previous = y;
+    }
+    // Each sub-block catches up on the previous one, so the slope stays near the sweep's own.
+    CHECK(maxStep <= 2.0f * sweepSlope * 1.01f);
+    CHECK(maxLag <= 2.0f * static_cast<float>(length) * sweepSlope * 1.01f);
+
+    // Once the target stops, the ramp lands on it within two ramp lengths.
+    for (int i = 0; i < 2 * length; ++i) (void)ramp.process();
+    CHECK(ramp.getValue() == target);
+    CHECK_FALSE(ramp.isRamping());
+}
+
+TEST_CASE("ParameterRamp reset jumps without ramping") {
+    ParameterRamp ramp(5.0f);
+    ramp.setSampleRate(44100.0f);
+    ramp.setTarget(ONE);
+    (void)ramp.process();
+    CHECK(ramp.isRamping());
+    ramp.reset(0.25f);
+    CHECK_FALSE(ramp.isRamping());
+    CHECK(ramp.process() == 0.25f);
+    CHECK(ramp.getTarget() == 0.25f);
+}
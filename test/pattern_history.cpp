@@ -0,0 +1,197 @@
+#include "doctest.h"
+#include "../src/dsp/sequencer/pattern_history.hpp"
+#include <atomic>
+#include <thread>
+
+using namespace clonotribe;
+
+namespace {
+PatternState patternWithPitch(float pitch, int step = 0) {
+    PatternState state;
+    state.steps[static_cast<size_t>(step)].pitch = pitch;
+    return state;
+}
+}
+
+TEST_CASE("PatternHistory commits only changes") {
+    PatternHistory history;
+    history.reset(PatternState{});
+    CHECK_FALSE(history.canUndo());
+    CHECK_FALSE(history.commit(PatternState{}));
+    CHECK(history.commit(patternWithPitch(ONE)));
+    CHECK(history.canUndo());
+    CHECK(history.current()->state() == patternWithPitch(ONE));
+}
+
+TEST_CASE("PatternHistory shares untouched step blocks") {
+    PatternHistory history;
+    history.reset(PatternState{});
+    auto before = history.current();
+    history.commit(patternWithPitch(ONE, 5));
+    auto after = history.current();
+    for (int b = 0; b < PatternSnapshot::BLOCKS; ++b) {
+        CAPTURE(b);
+        bool touched = b == 5 / PatternSnapshot::BLOCK_SIZE;
+        CHECK((before->blocks[static_cast<size_t>(b)] == after->blocks[static_cast<size_t>(b)]) != touched);
+    }
+}
+
+TEST_CASE("PatternHistory undo and redo walk the versions") {
+    PatternHistory history;
+    history.reset(PatternState{});
+    history.commit(patternWithPitch(ONE));
+    history.commit(patternWithPitch(TWO));
+
+    auto undone = history.undo();
+    REQUIRE(undone);
+    CHECK(undone->state() == patternWithPitch(ONE));
+    undone = history.undo();
+    REQUIRE(undone);
+    CHECK(undone->state() == PatternState{});
+    CHECK_FALSE(history.undo());
+
+    auto redone = history.redo();
+    REQUIRE(redone);
+    CHECK(redone->state() == patternWithPitch(ONE));
+    redone = history.redo();
+    REQUIRE(redone);
+    CHECK(redone->state() == patternWithPitch(TWO));
+    CHECK_FALSE(history.redo());
+}
+
+TEST_CASE("PatternHistory drops the redo branch on a new edit") {
+    PatternHistory history;
+    history.reset(PatternState{});
+    history.commit(patternWithPitch(ONE));
+    history.commit(patternWithPitch(TWO));
+    (void)history.undo();
+    CHECK(history.canRedo());
+
+    history.commit(patternWithPitch(3.0f));
+    CHECK_FALSE(history.canRedo());
+    CHECK_FALSE(history.redo());
+    auto undone = history.undo();
+    REQUIRE(undone);
+    CHECK(undone->state() == patternWithPitch(ONE));
+}
+
+TEST_CASE("PatternHistory keeps at most MAX_DEPTH undo steps") {
+    PatternHistory history;
+    history.reset(PatternState{});
+    const int edits = static_cast<int>(PatternHistory::MAX_DEPTH) + 10;
+    for (int i = 1; i <= edits; ++i) {
+        history.commit(patternWithPitch(static_cast<float>(i)));
+    }
+    CHECK(history.undoDepth() == PatternHistory::MAX_DEPTH);
+
+    PatternHistory::SnapshotPtr oldest;
+    while (auto undone = history.undo()) oldest = undone;
+    REQUIRE(oldest);
+    CHECK(oldest->state() == patternWithPitch(static_cast<float>(edits - static_cast<int>(PatternHistory::MAX_DEPTH))));
+    CHECK(history.redoDepth() == PatternHistory::MAX_DEPTH);
+}
+
+TEST_CASE("PatternMailbox hands over the newest edit once") {
+    PatternMailbox mailbox;
+    CHECK(mailbox.take() == nullptr);
+
+    for (int i = 1; i <= 2; ++i) {
+        PatternEdit& edit = mailbox.edit();
+        edit.state = patternWithPitch(static_cast<float>(i));
+        edit.basis = static_cast<uint32_t>(i);
+        mailbox.publish();
+    }
+    const PatternEdit* edit = mailbox.take();
+    REQUIRE(edit);
+    CHECK(edit->basis == 2);
+    CHECK(edit->state == patternWithPitch(TWO));
+    CHECK(mailbox.take() == nullptr);
+}
+
+TEST_CASE("PatternHandoff keeps a publication until it is acknowledged") {
+    PatternHandoff handoff;
+    PatternHistory history;
+    history.reset(patternWithPitch(ONE));
+    std::weak_ptr<const PatternSnapshot> first = history.current();
+    handoff.publish(history.current(), false);
+    history.reset(patternWithPitch(TWO));
+    handoff.publish(history.current(), true);
+    history.reset(PatternState{});
+
+    // The audio thread started on the first publication before the second one arrived.
+    handoff.collect();
+    CHECK(handoff.retained() == 2);
+    CHECK_FALSE(first.expired());
+
+    const auto* newest = handoff.take();
+    REQUIRE(newest);
+    CHECK(newest->sequence == 2);
+    CHECK(newest->recordsEdit);
+    CHECK(newest->snapshot->state() == patternWithPitch(TWO));
+    handoff.acknowledge(newest);
+    CHECK(handoff.take() == nullptr);
+
+    handoff.collect();
+    CHECK(handoff.retained() == 0);
+    CHECK(first.expired());
+}
+
+TEST_CASE("PatternHandoff discard returns the superseded sequence") {
+    PatternHandoff handoff;
+    PatternHistory history;
+    history.reset(patternWithPitch(ONE));
+    handoff.publish(history.current(), false);
+    CHECK(handoff.discard() == 1);
+    CHECK(handoff.take() == nullptr);
+    CHECK(handoff.latest() == 1);
+}
+
+TEST_CASE("Pattern exchange between threads never tears or frees early") {
+    constexpr int ROUNDS = 20000;
+    PatternMailbox mailbox;
+    PatternHandoff handoff;
+    std::atomic<bool> done{false};
+    std::atomic<int> torn{0};
+
+    // Audio side: posts edits whose pitches all match their drum mask, and adopts publications.
+    std::thread audio([&] {
+        uint64_t k = 0;
+        while (!done.load(std::memory_order_acquire)) {
+            if (const auto* publication = handoff.take()) {
+                const PatternSnapshot& snapshot = *publication->snapshot;
+                float expected = static_cast<float>(snapshot.drums.hits[0]);
+                for (int i = 0; i < Sequencer::MAX_STEPS; ++i) {
+                    if (snapshot.step(i).pitch != expected) torn.fetch_add(1);
+                }
+                handoff.acknowledge(publication);
+            }
+            ++k;
+            PatternEdit& edit = mailbox.edit();
+            for (auto& step : edit.state.steps) step.pitch = static_cast<float>(k);
+            edit.state.drums.hits[0] = k;
+            mailbox.publish();
+        }
+    });
+
+    PatternHistory history;
+    for (int round = 1; round <= ROUNDS; ++round) {
+        if (const PatternEdit* edit = mailbox.take()) {
+            float expected = static_cast<float>(edit->state.drums.hits[0]);
+            for (const auto& step : edit->state.steps) {
+                if (step.pitch != expected) torn.fetch_add(1);
+            }
+        }
+        PatternState state;
+        for (auto& step : state.steps) step.pitch = static_cast<float>(round);
+        state.drums.hits[0] = static_cast<uint64_t>(round);
+        history.reset(state);
+        handoff.publish(history.current(), false);
+    }
+    while (handoff.take()) std::this_thread::yield();
+    done.store(true, std::memory_order_release);
+    audio.join();
+
+    CHECK(torn.load() == 0);
+    handoff.collect();
+    CHECK(handoff.retained() == 0);
+}
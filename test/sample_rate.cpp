@@ -0,0 +1,139 @@
+#include "doctest.h"
+#include "../src/dsp/fastmath.hpp"
+#include "../src/dsp/drumkits/base/drum_processor.hpp"
+#include "../src/dsp/filter_processor.hpp"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using clonotribe::DrumKitType;
+using clonotribe::DrumProcessor;
+using clonotribe::FastMath;
+using clonotribe::FilterProcessor;
+using clonotribe::FilterSolver;
+using clonotribe::FilterType;
+using clonotribe::LadderFilter;
+using clonotribe::MoogFilter;
+using clonotribe::MS20Filter;
+using clonotribe::NoiseGenerator;
+
+namespace {
+constexpr float RATES[] = {44100.0f, 48000.0f, 96000.0f, 192000.0f};
+constexpr float WINDOW_SECONDS = 0.005f;
+constexpr float FLOOR_DB = -40.0f;
+
+enum class Drum { KICK, SNARE, HIHAT };
+
+// RMS level in dB of consecutive 5 ms windows, relative to the loudest window.
+std::vector<float> levelContour(const std::vector<float>& signal, float sampleRate) {
+    const size_t window = static_cast<size_t>(WINDOW_SECONDS * sampleRate);
+    std::vector<float> levels;
+    for (size_t start = 0; start + window <= signal.size(); start += window) {
+        double sum = 0.0;
+        for (size_t i = start; i < start + window; ++i) sum += static_cast<double>(signal[i]) * signal[i];
+        levels.push_back(10.0f * std::log10(static_cast<float>(sum / static_cast<double>(window)) + 1e-20f));
+    }
+    const float peak = *std::max_element(levels.begin(), levels.end());
+    for (float& level : levels) level = std::max(level - peak, FLOOR_DB - 20.0f);
+    return levels;
+}
+
+std::vector<float> renderDrum(DrumKitType kit, Drum drum, float sampleRate, float seconds) {
+    DrumProcessor drums;
+    drums.setSampleRate(sampleRate);
+    drums.setDrumKit(kit);
+    NoiseGenerator noise;
+    switch (drum) {
+        case Drum::KICK: drums.triggerKick(); break;
+        case Drum::SNARE: drums.triggerSnare(); break;
+        case Drum::HIHAT: drums.triggerHihat(); break;
+    }
+    std::vector<float> out(static_cast<size_t>(seconds * sampleRate));
+    for (float& y : out) {
+        switch (drum) {
+            case Drum::KICK: y = drums.processKick(ZERO, ZERO, noise); break;
+            case Drum::SNARE: y = drums.processSnare(ZERO, ZERO, noise); break;
+            case Drum::HIHAT: y = drums.processHihat(ZERO, ZERO, noise); break;
+        }
+    }
+    return out;
+}
+
+// Largest level difference over the windows where either contour is above the floor.
+float contourDistance(const std::vector<float>& a, const std::vector<float>& b) {
+    float distance = ZERO;
+    for (size_t i = 0; i < std::min(a.size(), b.size()); ++i) {
+        if (a[i] > FLOOR_DB || b[i] > FLOOR_DB) distance = std::max(distance, std::abs(a[i] - b[i]));
+    }
+    return distance;
+}
+}
+
+TEST_CASE("Drums keep their envelopes at every sample rate") {
+    const DrumKitType kits[] = {DrumKitType::ORIGINAL, DrumKitType::TR808, DrumKitType::LATIN};
+    const Drum drums[] = {Drum::KICK, Drum::SNARE, Drum::HIHAT};
+    for (DrumKitType kit : kits) {
+        for (Drum drum : drums) {
+            const std::vector<float> reference = levelContour(renderDrum(kit, drum, RATES[0], 1.0f), RATES[0]);
+            for (float sampleRate : RATES) {
+                const float distance = contourDistance(reference, levelContour(renderDrum(kit, drum, sampleRate, 1.0f), sampleRate));
+                CAPTURE(static_cast<int>(kit));
+                CAPTURE(static_cast<int>(drum));
+                CAPTURE(sampleRate);
+                MESSAGE("kit " << static_cast<int>(kit) << " drum " << static_cast<int>(drum) << " at " << sampleRate << " Hz: " << distance << " dB");
+                CHECK(distance < 2.5f);
+            }
+        }
+    }
+}
+
+namespace {
+// Steady-state gain in dB of a filter model for a sine at `frequency`.
+float filterGain(FilterType type, FilterSolver solver, float sampleRate, float frequency) {
+    MS20Filter ms20;
+    LadderFilter ladder;
+    MoogFilter moog;
+    FilterProcessor processor(ms20);
+    processor.setFilterType(type, &ms20, &ladder, &moog);
+    processor.setSolver(solver);
+    processor.setSampleRate(sampleRate);
+    processor.setActive(true);
+    const int settle = static_cast<int>(0.2f * sampleRate);
+    const int measure = static_cast<int>(0.1f * sampleRate);
+    double inputPower = 0.0;
+    double outputPower = 0.0;
+    for (int i = 0; i < settle + measure; ++i) {
+        float x = 0.1f * FastMath::sin(FastMath::TWO_PI * frequency * static_cast<float>(i) / sampleRate);
+        float y = processor.process(x, 0.5f, 0.3f);
+        if (i >= settle) {
+            inputPower += static_cast<double>(x) * x;
+            outputPower += static_cast<double>(y) * y;
+        }
+    }
+    return 10.0f * std::log10(static_cast<float>(outputPower / inputPower));
+}
+}
+
+TEST_CASE("Filters keep their response at every sample rate") {
+    const FilterType types[] = {FilterType::MS20, FilterType::LADDER, FilterType::MOOG};
+    for (FilterSolver solver : {FilterSolver::EULER, FilterSolver::ZDF}) {
+        // The Euler ladder's unit-delay feedback error shrinks with the rate; that is accuracy,
+        // not a coefficient left at 44.1 kHz.
+        const float tolerance = solver == FilterSolver::EULER ? 1.5f : 1.0f;
+        for (FilterType type : types) {
+            for (float frequency : {100.0f, 500.0f, 1000.0f, 2000.0f, 5000.0f}) {
+                const float reference = filterGain(type, solver, RATES[0], frequency);
+                if (reference < -60.0f) continue;
+                for (float sampleRate : RATES) {
+                    const float gain = filterGain(type, solver, sampleRate, frequency);
+                    CAPTURE(static_cast<int>(solver));
+                    CAPTURE(static_cast<int>(type));
+                    CAPTURE(frequency);
+                    CAPTURE(sampleRate);
+                    MESSAGE("solver " << static_cast<int>(solver) << " filter " << static_cast<int>(type) << " at " << frequency << " Hz, " << sampleRate << " Hz: " << gain - reference << " dB");
+                    CHECK(std::abs(gain - reference) < tolerance);
+                }
+            }
+        }
+    }
+}
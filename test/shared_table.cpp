@@ -0,0 +1,44 @@
+#include "doctest.h"
+#include "../src/dsp/shared_table.hpp"
+#include "../src/dsp/distortion.hpp"
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+using clonotribe::Distortion;
+using clonotribe::SharedTable;
+
+namespace {
+struct alignas(64) CountingTable {
+    static inline int builds = 0;
+    float values[16]{};
+    CountingTable() { ++builds; }
+};
+}
+
+TEST_CASE("SharedTable builds once and is shared by every handle") {
+    CountingTable::builds = 0;
+    {
+        std::vector<SharedTable<CountingTable>> handles(50);
+        CHECK(CountingTable::builds == 1);
+        CHECK(SharedTable<CountingTable>::users() == 50);
+        for (const auto& handle : handles) CHECK(handle.get() == handles.front().get());
+        CHECK(reinterpret_cast<std::uintptr_t>(handles.front().get()) % 64 == 0);
+    }
+    CHECK(SharedTable<CountingTable>::users() == 0);
+    SharedTable<CountingTable> again;
+    CHECK(CountingTable::builds == 2);
+}
+
+TEST_CASE("SharedTable keeps 50 distortions on one shaper table") {
+    using clock = std::chrono::steady_clock;
+    auto start = clock::now();
+    std::vector<Distortion> first(1);
+    auto firstNs = std::chrono::duration<double, std::micro>(clock::now() - start).count();
+    start = clock::now();
+    std::vector<Distortion> rest(49);
+    auto restNs = std::chrono::duration<double, std::micro>(clock::now() - start).count();
+    CHECK(SharedTable<Distortion::ShaperTable>::users() == 50);
+    MESSAGE("Distortion construction: first " << firstNs << " us, next 49 " << restNs << " us, table "
+        << sizeof(Distortion::ShaperTable) / 1024 << " KiB shared");
+}
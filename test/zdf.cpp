@@ -0,0 +1,143 @@
+#include "doctest.h"
+#include "../src/dsp/vcf/ms20.hpp"
+#include "../src/dsp/vcf/ladder.hpp"
+#include "../src/dsp/oversampler.hpp"
+#include <chrono>
+#include <cmath>
+
+using clonotribe::FastMath;
+using clonotribe::FilterSolver;
+using clonotribe::LadderFilter;
+using clonotribe::MS20Filter;
+using clonotribe::Oversampler;
+
+namespace {
+constexpr float SAMPLE_RATE = 44100.0f;
+
+float cutoffParamFor(float hz) {
+    return std::log(hz / 20.0f) / 7.0f;
+}
+
+// Frequency of the ringing after a small impulse at full resonance (kept small so the tanh stays
+// linear), from interpolated upward zero crossings.
+float ringingFrequency(FilterSolver solver, float hz) {
+    LadderFilter filter;
+    filter.setSampleRate(SAMPLE_RATE);
+    filter.setSolver(solver);
+    filter.setCutoff(cutoffParamFor(hz));
+    filter.setResonance(ONE);
+    float previous = filter.process(0.01f);
+    double first = -1.0;
+    double last = -1.0;
+    int crossings = 0;
+    for (int i = 1; i < 8000; ++i) {
+        float y = filter.process(ZERO);
+        if (i > 2000 && previous < ZERO && y >= ZERO) {
+            double at = static_cast<double>(i - 1) + static_cast<double>(previous / (previous - y));
+            if (first < 0.0) {
+                first = at;
+            } else {
+                ++crossings;
+            }
+            last = at;
+        }
+        previous = y;
+    }
+    if (crossings == 0) return ZERO;
+    return static_cast<float>(static_cast<double>(crossings) * SAMPLE_RATE / (last - first));
+}
+
+template<typename Filter>
+float maxOutput(Filter& filter) {
+    float peak = ZERO;
+    for (int i = 0; i < 44100; ++i) {
+        float y = filter.process((i / 20) % 2 ? 5.0f : -5.0f);
+        peak = std::isfinite(y) ? std::max(peak, std::abs(y)) : INFINITY;
+    }
+    return peak;
+}
+
+template<typename Filter>
+double nsPerSample(FilterSolver solver, int factor) {
+    constexpr int SAMPLES = 1 << 17;
+    Filter filter;
+    filter.setSampleRate(SAMPLE_RATE * static_cast<float>(factor));
+    filter.setSolver(solver);
+    filter.setCutoff(0.8f);
+    filter.setResonance(0.6f);
+    Oversampler oversampler;
+    oversampler.setFactor(factor);
+    float sink = ZERO;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < SAMPLES; ++i) {
+        float x = (i & 64) ? 0.5f : -0.5f;
+        sink += factor == 1 ? filter.process(x) : oversampler.process(x, [&](float v) { return filter.process(v); });
+    }
+    auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    CHECK(std::isfinite(sink));
+    return elapsed / SAMPLES;
+}
+}
+
+TEST_CASE("ZDF ladder self-oscillates at the cutoff up to Nyquist") {
+    for (float hz : {1000.0f, 5000.0f, 10000.0f, 15000.0f}) {
+        CAPTURE(hz);
+        float zdf = ringingFrequency(FilterSolver::ZDF, hz);
+        float euler = ringingFrequency(FilterSolver::EULER, hz);
+        MESSAGE("Ladder at " << hz << " Hz rings at: ZDF " << zdf << " Hz, Euler " << euler << " Hz");
+        CHECK(std::abs(zdf / hz - ONE) < 0.01f);
+    }
+}
+
+TEST_CASE("ZDF filters stay bounded at full cutoff and resonance") {
+    MS20Filter ms20;
+    LadderFilter ladder;
+    ms20.setSampleRate(SAMPLE_RATE);
+    ladder.setSampleRate(SAMPLE_RATE);
+    ms20.setSolver(FilterSolver::ZDF);
+    ladder.setSolver(FilterSolver::ZDF);
+    ms20.setCutoff(ONE);
+    ladder.setCutoff(ONE);
+    ms20.setResonance(ONE);
+    ladder.setResonance(ONE);
+    CHECK(maxOutput(ms20) < 4.0f);
+    CHECK(maxOutput(ladder) < 4.0f);
+}
+
+TEST_CASE("ZDF MS20 sounds like the Euler MS20 at low cutoff") {
+    MS20Filter euler;
+    MS20Filter zdf;
+    euler.setSampleRate(SAMPLE_RATE);
+    zdf.setSampleRate(SAMPLE_RATE);
+    zdf.setSolver(FilterSolver::ZDF);
+    for (MS20Filter* filter : {&euler, &zdf}) {
+        filter->setCutoff(cutoffParamFor(600.0f));
+        filter->setResonance(0.3f);
+    }
+    double eulerEnergy = 0.0;
+    double differenceEnergy = 0.0;
+    for (int i = 0; i < 44100; ++i) {
+        float x = 0.5f * std::sin(2.0f * FastMath::PI * 110.0f * static_cast<float>(i) / SAMPLE_RATE);
+        float a = euler.process(x);
+        float b = zdf.process(x);
+        if (i > 4410) {
+            eulerEnergy += static_cast<double>(a) * a;
+            differenceEnergy += static_cast<double>(a - b) * (a - b);
+        }
+    }
+    CHECK(std::sqrt(differenceEnergy / eulerEnergy) < 0.1);
+}
+
+// The ZDF solver has to pay for itself: at 1x it must cost less than the Euler models at 2x.
+TEST_CASE("ZDF cost against 2x oversampled Euler") {
+    double ms20Euler = nsPerSample<MS20Filter>(FilterSolver::EULER, 1);
+    double ms20Euler2x = nsPerSample<MS20Filter>(FilterSolver::EULER, 2);
+    double ms20Zdf = nsPerSample<MS20Filter>(FilterSolver::ZDF, 1);
+    double ladderEuler = nsPerSample<LadderFilter>(FilterSolver::EULER, 1);
+    double ladderEuler2x = nsPerSample<LadderFilter>(FilterSolver::EULER, 2);
+    double ladderZdf = nsPerSample<LadderFilter>(FilterSolver::ZDF, 1);
+    MESSAGE("MS20 ns/sample: Euler " << ms20Euler << ", Euler 2x " << ms20Euler2x << ", ZDF " << ms20Zdf);
+    MESSAGE("Ladder ns/sample: Euler " << ladderEuler << ", Euler 2x " << ladderEuler2x << ", ZDF " << ladderZdf);
+    CHECK(ms20Zdf < ms20Euler2x);
+    CHECK(ladderZdf < ladderEuler2x);
+}